@@ -7,6 +7,7 @@
 #include <WiFi.h>
 
 #include "display.h"
+#include "display_bench.h"
 #include "touch.h"
 #include "rtc_clock.h"
 #include "sd_card.h"
@@ -15,6 +16,10 @@
 #include "power.h"
 #include "bluetooth.h"
 #include "notification_ui.h"
+#include "notification_log.h"
+#include "notification_rules.h"
+#include "diagnostics.h"
+#include "perf.h"
 
 // EEZ Studio generated UI
 #include "ui/WizWatch/src/ui/ui.h"
@@ -25,9 +30,7 @@ HWCDC USBSerial;
 
 uint32_t screenWidth;
 uint32_t screenHeight;
-uint32_t bufSize;
 lv_display_t *disp;
-lv_color_t *disp_draw_buf;
 
 uint32_t millis_cb(void) {
   return millis();
@@ -62,6 +65,8 @@ void setup() {
   lv_tick_set_cb(millis_cb);
 
   sd_card_init();
+  notification_log_init();
+  notification_rules_init();
 
 #if LV_USE_LOG != 0
   lv_log_register_print_cb(my_print);
@@ -70,39 +75,17 @@ void setup() {
   screenWidth = gfx->width();
   screenHeight = gfx->height();
 
-#ifdef DIRECT_RENDER_MODE
-  bufSize = screenWidth * screenHeight;
-#else
-  bufSize = screenWidth * 80;  // Increased from 50 to 80 for smoother animations
-#endif
+  // Render mode and band height come from the SD card when present
+  display_config_t displayConfig;
+  display_load_config(&displayConfig);
 
-#ifdef ESP32
-#if defined(DIRECT_RENDER_MODE) && (defined(CANVAS) || defined(RGB_PANEL) || defined(DSI_PANEL))
-  disp_draw_buf = (lv_color_t *)gfx->getFramebuffer();
-#else
-  disp_draw_buf = (lv_color_t *)heap_caps_malloc(bufSize * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-  if (!disp_draw_buf) {
-    disp_draw_buf = (lv_color_t *)heap_caps_malloc(bufSize * 2, MALLOC_CAP_8BIT);
-  }
-#endif
-#else
-  disp_draw_buf = (lv_color_t *)malloc(bufSize * 2);
-#endif
-  if (!disp_draw_buf) {
+  disp = display_create(screenWidth, screenHeight, &displayConfig);
+  if (!disp) {
     USBSerial.println("LVGL disp_draw_buf allocate failed!");
   } else {
-    disp = lv_display_create(screenWidth, screenHeight);
-    lv_display_set_flush_cb(disp, my_disp_flush);
-#ifdef DIRECT_RENDER_MODE
-    lv_display_set_buffers(disp, disp_draw_buf, NULL, bufSize * 2, LV_DISPLAY_RENDER_MODE_DIRECT);
-#else
-    lv_display_set_buffers(disp, disp_draw_buf, NULL, bufSize * 2, LV_DISPLAY_RENDER_MODE_PARTIAL);
-#endif
-
     lv_indev_t *indev = lv_indev_create();
     lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(indev, my_touchpad_read);
-    lv_display_add_event_cb(disp, rounder_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
 
     ui_init();
 
@@ -123,10 +106,15 @@ void setup() {
 
     // Set initial time to avoid flicker from default value
     rtc_update_display();
+
+    display_measure_full_redraw();
   }
 
   // Initialize notification overlay (after UI)
   notification_ui_init();
+  diagnostics_init();
+  perf_init();  // no-op unless built with WIZWATCH_PERF
+  display_bench_run(disp, displayConfig.bench);
 
   // Initialize Bluetooth last (after UI is ready)
   bluetooth_init();
@@ -136,9 +124,16 @@ void setup() {
 
 void loop() {
   static uint32_t lastBatteryUpdate = 0;
+
+  // While asleep, block until touch, the PMU or a BLE write signals us
+  uint32_t wake = 0;
+  if (power_is_sleeping()) {
+    wake = power_wait_for_wake();
+  }
   uint32_t now = millis();
 
-  // Always check power button (wake source)
+  // Power button (wake source); only touches I2C on a PMU IRQ edge or when
+  // the poll interval is due
   power_check_button();
 
   // Skip most processing if sleeping
@@ -146,37 +141,45 @@ void loop() {
     if (touch_has_activity()) {
       notification_ui_set_sleep_bg(false);
       power_wake();
-    } else if (bluetooth_has_pending_data()) {
-      notification_ui_set_sleep_bg(true);
-      power_wake();
     } else {
-      delay(100);
-      return;
+      // Apply BLE events with the screen off; notifications that pass the
+      // rules, calls and find requests wake it themselves
+      bool pending = bluetooth_has_pending_data();
+      bluetooth_update();
+      if (power_is_sleeping()) {
+        if (wake && !pending) power_note_idle_wakeup();
+        return;
+      }
     }
   }
 
   // ===== AWAKE MODE =====
 
+  PERF_BEGIN(PERF_LOOP);
+  PERF_BEGIN(PERF_LVGL);
   lv_task_handler();
+  PERF_END(PERF_LVGL);
 
   if (power_is_sleeping()) return;
 
-#ifdef DIRECT_RENDER_MODE
-#if defined(CANVAS) || defined(RGB_PANEL) || defined(DSI_PANEL)
-  gfx->flush();
-#else
-  gfx->draw16bitRGBBitmap(0, 0, (uint16_t *)disp_draw_buf, screenWidth, screenHeight);
-#endif
-#else
 #ifdef CANVAS
   gfx->flush();
-#endif
 #endif
 
+  PERF_BEGIN(PERF_UI_TICK);
   ui_tick();
+  PERF_END(PERF_UI_TICK);
+  PERF_BEGIN(PERF_RTC);
   rtc_tick();
+  PERF_END(PERF_RTC);
+  PERF_BEGIN(PERF_BRIGHTNESS);
   brightness_update();
+  PERF_END(PERF_BRIGHTNESS);
+  PERF_BEGIN(PERF_BLUETOOTH);
   bluetooth_update();  // Handle BLE connections
+  PERF_END(PERF_BLUETOOTH);
+  notification_log_tick();  // Batched SD writes of notification history
+  diagnostics_poll();  // "stats" on the serial console
   power_check_inactivity();  // Auto-sleep after 30s of no touch
 
   // Update battery less frequently (every 5 seconds instead of every loop)
@@ -185,6 +188,8 @@ void loop() {
     lastBatteryUpdate = now;
   }
 
+  PERF_END(PERF_LOOP);
+
   // Minimal delay for responsiveness
   delay(1);
 }
@@ -0,0 +1,151 @@
+#include "ble_adv.h"
+#include <esp_gap_ble_api.h>
+#include <esp_timer.h>
+#include "HWCDC.h"
+
+extern HWCDC USBSerial;
+
+static esp_timer_handle_t stepTimer = nullptr;
+static portMUX_TYPE advLock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool advertising = false;
+static uint16_t interval = 0;           // current min interval
+static uint32_t levelStart = 0;         // millis() when the current interval began
+static uint32_t disconnectedAt = 0;    // 0 = no disconnect to time (boot, or already counted)
+
+static ble_adv_stats_t stats;
+static uint64_t reconnectTotalMs = 0;
+
+// Charge time at the current interval to the stats (advLock held)
+static void accountLevel(uint32_t now) {
+    if (!advertising) return;
+    uint32_t elapsed = now - levelStart;
+    stats.advertisingMs += elapsed;
+    if (interval == BLE_ADV_FAST_MIN) stats.fastMs += elapsed;
+    stats.advEvents += (uint64_t)elapsed * 1000 / (interval * 625);
+    levelStart = now;
+}
+
+// Restart advertising with new timing; the advertising data stays configured
+static void startAt(uint16_t min) {
+    esp_ble_adv_params_t params = {};
+    params.adv_int_min = min;
+    params.adv_int_max = min == BLE_ADV_SLOW_MIN ? BLE_ADV_SLOW_MAX : min * 2;
+    params.adv_type = ADV_TYPE_IND;
+    params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    params.channel_map = ADV_CHNL_ALL;
+    params.adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+    esp_ble_gap_stop_advertising();
+    esp_ble_gap_start_advertising(&params);
+}
+
+static void stepTimerCb(void *arg) {
+    (void)arg;
+    uint16_t next = 0;
+    uint32_t waitMs = 0;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&advLock);
+    if (advertising && interval < BLE_ADV_SLOW_MIN) {
+        uint32_t elapsed = now - levelStart;
+        if (elapsed < BLE_ADV_STEP_MS) {
+            // An interaction restarted the level; wait out the rest
+            waitMs = BLE_ADV_STEP_MS - elapsed;
+        } else {
+            accountLevel(now);
+            interval = interval * 2 < BLE_ADV_SLOW_MIN ? interval * 2 : BLE_ADV_SLOW_MIN;
+            next = interval;
+            if (next < BLE_ADV_SLOW_MIN) waitMs = BLE_ADV_STEP_MS;
+        }
+    }
+    portEXIT_CRITICAL(&advLock);
+
+    if (next) {
+        startAt(next);
+        USBSerial.printf("[BLE] Advertising backed off to %u ms\n", next * 625 / 1000);
+    }
+    if (waitMs) esp_timer_start_once(stepTimer, (uint64_t)waitMs * 1000);
+}
+
+void ble_adv_init() {
+    esp_timer_create_args_t args = {};
+    args.callback = stepTimerCb;
+    args.name = "ble_adv";
+    esp_timer_create(&args, &stepTimer);
+
+    // bluetooth_init() already started advertising at the fast interval
+    advertising = true;
+    interval = BLE_ADV_FAST_MIN;
+    levelStart = millis();
+    esp_timer_start_once(stepTimer, (uint64_t)BLE_ADV_STEP_MS * 1000);
+}
+
+void ble_adv_start() {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&advLock);
+    accountLevel(now);
+    advertising = true;
+    interval = BLE_ADV_FAST_MIN;
+    levelStart = now;
+    portEXIT_CRITICAL(&advLock);
+
+    startAt(BLE_ADV_FAST_MIN);
+    esp_timer_stop(stepTimer);
+    esp_timer_start_once(stepTimer, (uint64_t)BLE_ADV_STEP_MS * 1000);
+}
+
+void ble_adv_stop() {
+    esp_timer_stop(stepTimer);
+    portENTER_CRITICAL(&advLock);
+    accountLevel(millis());
+    advertising = false;
+    interval = 0;
+    portEXIT_CRITICAL(&advLock);
+    esp_ble_gap_stop_advertising();
+}
+
+void ble_adv_interaction() {
+    bool restart = false;
+    portENTER_CRITICAL(&advLock);
+    if (advertising) {
+        if (interval == BLE_ADV_FAST_MIN) levelStart = millis();  // stay fast a while longer
+        else restart = true;
+    }
+    portEXIT_CRITICAL(&advLock);
+    if (restart) ble_adv_start();
+}
+
+void ble_adv_disconnected() {
+    portENTER_CRITICAL(&advLock);
+    disconnectedAt = millis();
+    portEXIT_CRITICAL(&advLock);
+}
+
+void ble_adv_connected() {
+    esp_timer_stop(stepTimer);
+    uint32_t now = millis();
+    portENTER_CRITICAL(&advLock);
+    accountLevel(now);
+    advertising = false;
+    interval = 0;
+
+    // The first connection after boot is not a reconnect
+    if (disconnectedAt) {
+        uint32_t latency = now - disconnectedAt;
+        disconnectedAt = 0;
+        stats.reconnects++;
+        stats.reconnectLastMs = latency;
+        reconnectTotalMs += latency;
+        stats.reconnectAvgMs = reconnectTotalMs / stats.reconnects;
+        if (latency > stats.reconnectMaxMs) stats.reconnectMaxMs = latency;
+    }
+    portEXIT_CRITICAL(&advLock);
+}
+
+void ble_adv_get_stats(ble_adv_stats_t *out) {
+    portENTER_CRITICAL(&advLock);
+    accountLevel(millis());
+    *out = stats;
+    out->interval = interval;
+    portEXIT_CRITICAL(&advLock);
+}
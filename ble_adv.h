@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Advertising scheduler.
+// Advertising starts fast after a disconnect (or when the user picks the watch
+// up) so the phone reconnects quickly, then the interval doubles every
+// BLE_ADV_STEP_MS until it reaches the slow interval. Any interaction snaps it
+// back to fast. Intervals in 0.625 ms units.
+#define BLE_ADV_FAST_MIN   0x20    // 20 ms
+#define BLE_ADV_FAST_MAX   0x40    // 40 ms
+#define BLE_ADV_SLOW_MIN   0x640   // 1 s
+#define BLE_ADV_SLOW_MAX   0x800   // 1.28 s
+#define BLE_ADV_STEP_MS    30000   // time spent at each interval before backing off
+
+struct ble_adv_stats_t {
+    uint32_t advertisingMs;    // total time spent advertising
+    uint32_t fastMs;           // of which at the fast interval
+    uint32_t advEvents;        // estimated advertising events (radio wakeups)
+    uint16_t interval;         // current min interval, 0 when not advertising
+    uint32_t reconnects;
+    uint32_t reconnectLastMs;  // disconnect -> connect
+    uint32_t reconnectAvgMs;
+    uint32_t reconnectMaxMs;
+};
+
+// Call once the advertising data has been configured and advertising started
+void ble_adv_init();
+
+void ble_adv_start();         // (re)start at the fast interval
+void ble_adv_stop();
+void ble_adv_interaction();   // user activity: back to fast if advertising
+void ble_adv_disconnected();  // starts the reconnect-latency clock
+void ble_adv_connected();     // the stack stops advertising on connect
+
+void ble_adv_get_stats(ble_adv_stats_t *stats);
@@ -0,0 +1,166 @@
+#include "ble_conn.h"
+#include <BLEDevice.h>
+#include <esp_gap_ble_api.h>
+#include <esp_timer.h>
+#include "HWCDC.h"
+#include "ble_tx.h"
+
+extern HWCDC USBSerial;
+
+// Mode state is written by the UI loop, the BT host task and the boost timer
+static portMUX_TYPE connLock = portMUX_INITIALIZER_UNLOCKED;
+static bool connected = false;
+static esp_bd_addr_t peer;
+static ble_conn_mode_t baseMode = BLE_CONN_FAST;
+static bool boosted = false;
+static int requested = -1;              // mode last asked for on this link
+static esp_timer_handle_t boostTimer = nullptr;
+
+static ble_conn_stats_t stats;
+static uint32_t modeSince = 0;          // millis() of the last mode change
+
+static ble_conn_mode_t wantedMode() {
+    return boosted ? BLE_CONN_FAST : baseMode;
+}
+
+// Charge the time since the last change to the mode the watch wanted (connLock held)
+static void accountTime() {
+    uint32_t now = millis();
+    if (connected) {
+        if (wantedMode() == BLE_CONN_FAST) stats.fastMs += now - modeSince;
+        else stats.slowMs += now - modeSince;
+    }
+    modeSince = now;
+}
+
+static void apply() {
+    portENTER_CRITICAL(&connLock);
+    ble_conn_mode_t mode = wantedMode();
+    bool ask = connected && requested != mode;
+    if (ask) {
+        requested = mode;   // claimed before asking so no other task asks twice
+        stats.requests++;
+    }
+    esp_ble_conn_update_params_t params;
+    memcpy(params.bda, peer, sizeof(esp_bd_addr_t));
+    portEXIT_CRITICAL(&connLock);
+    if (!ask) return;
+
+    if (mode == BLE_CONN_FAST) {
+        params.min_int = BLE_CONN_FAST_MIN;
+        params.max_int = BLE_CONN_FAST_MAX;
+        params.latency = BLE_CONN_FAST_LATENCY;
+    } else {
+        params.min_int = BLE_CONN_SLOW_MIN;
+        params.max_int = BLE_CONN_SLOW_MAX;
+        params.latency = BLE_CONN_SLOW_LATENCY;
+    }
+    params.timeout = BLE_CONN_TIMEOUT;
+
+    if (esp_ble_gap_update_conn_params(&params) != ESP_OK) {
+        portENTER_CRITICAL(&connLock);
+        if (requested == mode) {
+            requested = -1;
+            stats.requests--;
+        }
+        portEXIT_CRITICAL(&connLock);
+    }
+}
+
+// Drop the boost once everything queued has gone out
+static void boostTimerCb(void *arg) {
+    (void)arg;
+    if (ble_tx_busy()) {
+        esp_timer_start_once(boostTimer, BLE_CONN_BOOST_CHECK_MS * 1000);
+        return;
+    }
+    portENTER_CRITICAL(&connLock);
+    accountTime();
+    boosted = false;
+    portEXIT_CRITICAL(&connLock);
+    apply();
+}
+
+// What the central actually granted
+static void gapEventHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+    if (event != ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT || !connected) return;
+
+    if (param->update_conn_params.status != ESP_BT_STATUS_SUCCESS) {
+        portENTER_CRITICAL(&connLock);
+        stats.rejected++;
+        requested = -1;  // ask again on the next mode change
+        portEXIT_CRITICAL(&connLock);
+        USBSerial.printf("[BLE] Conn param update rejected (%d)\n", param->update_conn_params.status);
+        return;
+    }
+    portENTER_CRITICAL(&connLock);
+    stats.interval = param->update_conn_params.conn_int;
+    stats.latency = param->update_conn_params.latency;
+    stats.timeout = param->update_conn_params.timeout;
+    portEXIT_CRITICAL(&connLock);
+    USBSerial.printf("[BLE] Conn params: %u.%02u ms, latency %u, timeout %u ms\n",
+        stats.interval * 125 / 100, stats.interval * 125 % 100, stats.latency, stats.timeout * 10);
+}
+
+void ble_conn_init() {
+    BLEDevice::setCustomGapHandler(gapEventHandler);
+    esp_timer_create_args_t args = {};
+    args.callback = boostTimerCb;
+    args.name = "ble_boost";
+    esp_timer_create(&args, &boostTimer);
+}
+
+void ble_conn_connected(const uint8_t *bda, uint16_t interval, uint16_t latency, uint16_t timeout) {
+    portENTER_CRITICAL(&connLock);
+    memcpy(peer, bda, sizeof(esp_bd_addr_t));
+    accountTime();
+    stats.interval = interval;
+    stats.latency = latency;
+    stats.timeout = timeout;
+    requested = -1;
+    connected = true;
+    portEXIT_CRITICAL(&connLock);
+    apply();
+}
+
+void ble_conn_disconnected() {
+    portENTER_CRITICAL(&connLock);
+    accountTime();
+    connected = false;
+    stats.interval = 0;
+    requested = -1;
+    uint32_t fastMs = stats.fastMs;
+    uint32_t slowMs = stats.slowMs;
+    portEXIT_CRITICAL(&connLock);
+    USBSerial.printf("[BLE] Link time: %lu s fast, %lu s slow\n", fastMs / 1000, slowMs / 1000);
+}
+
+void ble_conn_set_mode(ble_conn_mode_t mode) {
+    portENTER_CRITICAL(&connLock);
+    accountTime();
+    baseMode = mode;
+    portEXIT_CRITICAL(&connLock);
+    apply();
+}
+
+void ble_conn_boost() {
+    portENTER_CRITICAL(&connLock);
+    bool start = connected && !boosted;
+    if (start) {
+        accountTime();
+        boosted = true;
+    }
+    bool linked = connected;
+    portEXIT_CRITICAL(&connLock);
+    if (!linked) return;
+    if (start) apply();
+    esp_timer_stop(boostTimer);
+    esp_timer_start_once(boostTimer, BLE_CONN_BOOST_CHECK_MS * 1000);
+}
+
+void ble_conn_get_stats(ble_conn_stats_t *out) {
+    portENTER_CRITICAL(&connLock);
+    accountTime();
+    *out = stats;
+    portEXIT_CRITICAL(&connLock);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Connection-parameter manager.
+// Asks the phone for a short interval while the watch is awake or has data to
+// send, and a long interval with slave latency while the display is off. The
+// central may grant something else; what it actually granted is tracked from
+// the GAP events, and time is accounted per requested mode.
+//
+// Intervals in 1.25 ms units, supervision timeout in 10 ms units.
+#define BLE_CONN_FAST_MIN      0x06   // 7.5 ms
+#define BLE_CONN_FAST_MAX      0x12   // 22.5 ms
+#define BLE_CONN_FAST_LATENCY  0
+#define BLE_CONN_SLOW_MIN      0xF0   // 300 ms
+#define BLE_CONN_SLOW_MAX      0x190  // 500 ms
+#define BLE_CONN_SLOW_LATENCY  3      // interval * (latency + 1) stays <= 2 s
+#define BLE_CONN_TIMEOUT       600    // 6 s
+#define BLE_CONN_BOOST_CHECK_MS 1000  // how often a boost checks whether TX has drained
+
+enum ble_conn_mode_t {
+    BLE_CONN_FAST = 0,
+    BLE_CONN_SLOW,
+};
+
+struct ble_conn_stats_t {
+    uint16_t interval;      // granted, 1.25 ms units (0 = not connected)
+    uint16_t latency;
+    uint16_t timeout;       // 10 ms units
+    uint32_t requests;      // updates asked of the central
+    uint32_t rejected;      // updates that came back with an error
+    uint32_t fastMs;        // connected time with the fast mode requested (awake or boosted)
+    uint32_t slowMs;        // connected time with the slow mode requested
+};
+
+void ble_conn_init();
+
+// Link state from the server callbacks
+void ble_conn_connected(const uint8_t *bda, uint16_t interval, uint16_t latency, uint16_t timeout);
+void ble_conn_disconnected();
+
+// Mode that follows the power state (fast when awake, slow when asleep)
+void ble_conn_set_mode(ble_conn_mode_t mode);
+
+// Stay fast until the TX queue is empty, whatever the power state
+void ble_conn_boost();
+
+void ble_conn_get_stats(ble_conn_stats_t *stats);
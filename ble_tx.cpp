@@ -0,0 +1,256 @@
+#include "ble_tx.h"
+#include <BLECharacteristic.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/event_groups.h>
+#include <esp_timer.h>
+#include "HWCDC.h"
+
+extern HWCDC USBSerial;
+
+#define TX_TASK_STACK      3072
+#define TX_TASK_PRIORITY   2
+#define TX_TASK_CORE       0      // same core as the Bluedroid host task
+#define TX_CONGEST_WAIT_MS 500    // give up on a message if the link stays congested
+#define ATT_HEADER         3      // opcode + handle in every notification
+
+#define EVT_UNCONGESTED    (1 << 0)
+
+struct TxMsg {
+    int64_t queuedUs;
+    uint16_t len;
+    uint8_t kind;           // ble_tx_kind_t
+    uint8_t steps;          // volume presses packed into data, one line each
+    char data[BLE_TX_MSG_MAX + 2];
+};
+
+// Messages collected during one coalescing window (TX task only)
+static TxMsg batch[BLE_TX_QUEUE_LEN];
+static int batchCount = 0;
+// "\r\n" flush line + every message in the batch, back to back
+static char packed[2 + BLE_TX_QUEUE_LEN * (BLE_TX_MSG_MAX + 2)];
+
+static BLECharacteristic *txChar = nullptr;
+static QueueHandle_t txQueue = nullptr;
+static EventGroupHandle_t txEvents = nullptr;
+static volatile bool connected = false;
+static volatile bool inFlight = false;
+static volatile uint16_t mtu = 23;
+static ble_tx_stats_t stats;
+static uint64_t latencyTotalUs = 0;
+
+// Block until the stack reports the link is not congested
+static bool waitUncongested() {
+    if (xEventGroupGetBits(txEvents) & EVT_UNCONGESTED) return true;
+    stats.congestionWaits++;
+    return xEventGroupWaitBits(txEvents, EVT_UNCONGESTED, pdFALSE, pdTRUE,
+                               pdMS_TO_TICKS(TX_CONGEST_WAIT_MS)) & EVT_UNCONGESTED;
+}
+
+static bool notifyChunk(const uint8_t *data, size_t len) {
+    if (!connected || !waitUncongested()) return false;
+    txChar->setValue((uint8_t *)data, len);
+    txChar->notify();
+    stats.fragments++;
+    return true;
+}
+
+static int findPending(uint8_t kind) {
+    for (int i = batchCount - 1; i >= 0; i--) {
+        if (batch[i].kind == kind) return i;
+    }
+    return -1;
+}
+
+static void removePending(int idx) {
+    for (int i = idx; i < batchCount - 1; i++) batch[i] = batch[i + 1];
+    batchCount--;
+    stats.coalesced++;
+}
+
+// Take the last volume step off a pending entry
+static void removeStep(int idx) {
+    TxMsg &m = batch[idx];
+    if (m.steps <= 1) {
+        removePending(idx);
+        return;
+    }
+    m.len -= m.len / m.steps;   // every step is the same line
+    m.steps--;
+    stats.coalesced++;
+}
+
+// Add a message to the batch, merging it with whatever it supersedes
+static void addToBatch(const TxMsg &msg) {
+    int other;
+    switch (msg.kind) {
+    case BLE_TX_PLAYBACK:
+        // Only the latest play/pause state matters
+        while ((other = findPending(BLE_TX_PLAYBACK)) >= 0) removePending(other);
+        break;
+    case BLE_TX_VOLUME_UP:
+    case BLE_TX_FIND_START:
+    case BLE_TX_VOLUME_DOWN:
+    case BLE_TX_FIND_STOP: {
+        // Opposite commands cancel out; neither goes on air
+        static const uint8_t opposite[] = {
+            0, 0, BLE_TX_VOLUME_DOWN, BLE_TX_VOLUME_UP, BLE_TX_FIND_STOP, BLE_TX_FIND_START,
+        };
+        if ((other = findPending(opposite[msg.kind])) >= 0) {
+            if (msg.kind == BLE_TX_VOLUME_UP || msg.kind == BLE_TX_VOLUME_DOWN) removeStep(other);
+            else removePending(other);
+            stats.coalesced++;
+            return;
+        }
+        // Gadgetbridge turns each {"t":"music","n":"volumeup"} into exactly one
+        // step and reads no count, so presses in a row stay one line each; they
+        // share one batch entry, so a long burst doesn't fill the batch
+        if ((msg.kind == BLE_TX_VOLUME_UP || msg.kind == BLE_TX_VOLUME_DOWN) && batchCount > 0) {
+            TxMsg &last = batch[batchCount - 1];
+            if (last.kind == msg.kind && last.len + msg.len <= sizeof(last.data)) {
+                memcpy(&last.data[last.len], msg.data, msg.len);
+                last.len += msg.len;
+                last.steps++;
+                return;
+            }
+        }
+        // A second find start/stop in a row is a no-op
+        if ((msg.kind == BLE_TX_FIND_START || msg.kind == BLE_TX_FIND_STOP) && findPending(msg.kind) >= 0) {
+            stats.coalesced++;
+            return;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    batch[batchCount++] = msg;
+}
+
+// Send the batch as one flush line plus every message, split to the current MTU
+static bool transmitBatch() {
+    // Empty line first to flush any pending REPL state (like real Bangle.js)
+    size_t len = 0;
+    packed[len++] = '\r';
+    packed[len++] = '\n';
+    for (int i = 0; i < batchCount; i++) {
+        memcpy(&packed[len], batch[i].data, batch[i].len);
+        len += batch[i].len;
+    }
+
+    size_t chunk = mtu > ATT_HEADER ? mtu - ATT_HEADER : 20;
+    for (size_t off = 0; off < len; off += chunk) {
+        size_t n = len - off < chunk ? len - off : chunk;
+        if (!notifyChunk((const uint8_t *)&packed[off], n)) return false;
+    }
+    stats.batches++;
+    return true;
+}
+
+static void txTask(void *arg) {
+    (void)arg;
+    static TxMsg msg;
+    for (;;) {
+        if (xQueueReceive(txQueue, &msg, portMAX_DELAY) != pdTRUE) continue;
+        inFlight = true;
+        batchCount = 0;
+        addToBatch(msg);
+
+        // Interactive commands wait a moment for presses that supersede them;
+        // anything else goes out now, together with whatever is already queued
+        bool hold = msg.kind != BLE_TX_PLAIN;
+        TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(BLE_TX_COALESCE_MS);
+        while (batchCount < BLE_TX_QUEUE_LEN) {
+            TickType_t now = xTaskGetTickCount();
+            TickType_t wait = hold && (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+            if (xQueueReceive(txQueue, &msg, wait) != pdTRUE) break;
+            addToBatch(msg);
+            if (msg.kind == BLE_TX_PLAIN) hold = false;
+        }
+
+        if (batchCount == 0) {
+            // Everything cancelled out
+        } else if (transmitBatch()) {
+            int64_t now = esp_timer_get_time();
+            for (int i = 0; i < batchCount; i++) {
+                uint32_t latency = now - batch[i].queuedUs;
+                stats.sent += batch[i].steps;
+                latencyTotalUs += (uint64_t)latency * batch[i].steps;
+                if (latency > stats.latencyMaxUs) stats.latencyMaxUs = latency;
+            }
+            stats.latencyAvgUs = latencyTotalUs / stats.sent;
+        } else {
+            for (int i = 0; i < batchCount; i++) stats.dropped += batch[i].steps;
+        }
+        inFlight = false;
+    }
+}
+
+void ble_tx_init(BLECharacteristic *characteristic) {
+    txChar = characteristic;
+    txQueue = xQueueCreate(BLE_TX_QUEUE_LEN, sizeof(TxMsg));
+    txEvents = xEventGroupCreate();
+    xEventGroupSetBits(txEvents, EVT_UNCONGESTED);
+    xTaskCreatePinnedToCore(txTask, "ble_tx", TX_TASK_STACK, nullptr, TX_TASK_PRIORITY, nullptr, TX_TASK_CORE);
+}
+
+bool ble_tx_send(const char *json, ble_tx_kind_t kind) {
+    if (!connected || !txQueue) return false;
+
+    static TxMsg msg;  // only called from the UI thread
+    size_t len = strlen(json);
+    if (len > BLE_TX_MSG_MAX) {
+        stats.dropped++;
+        USBSerial.printf("[BLE] TX message too long (%u bytes)\n", (unsigned)len);
+        return false;
+    }
+    memcpy(msg.data, json, len);
+    msg.data[len++] = '\r';
+    msg.data[len++] = '\n';
+    msg.len = len;
+    msg.kind = kind;
+    msg.steps = 1;
+    msg.queuedUs = esp_timer_get_time();
+
+    if (xQueueSend(txQueue, &msg, 0) != pdTRUE) {
+        stats.dropped++;
+        USBSerial.println("[BLE] TX queue full, message dropped");
+        return false;
+    }
+    stats.queued++;
+    uint32_t depth = uxQueueMessagesWaiting(txQueue);
+    if (depth > stats.maxDepth) stats.maxDepth = depth;
+    return true;
+}
+
+void ble_tx_clear() {
+    if (txQueue) xQueueReset(txQueue);
+}
+
+void ble_tx_set_connected(bool on) {
+    connected = on;
+    if (!on) {
+        mtu = 23;
+        // Wake a sender stuck on congestion so it can bail out
+        if (txEvents) xEventGroupSetBits(txEvents, EVT_UNCONGESTED);
+    }
+}
+
+void ble_tx_set_mtu(uint16_t value) {
+    mtu = value;
+}
+
+void ble_tx_set_congested(bool congested) {
+    if (!txEvents) return;
+    if (congested) xEventGroupClearBits(txEvents, EVT_UNCONGESTED);
+    else xEventGroupSetBits(txEvents, EVT_UNCONGESTED);
+}
+
+bool ble_tx_busy() {
+    return inFlight || (txQueue && uxQueueMessagesWaiting(txQueue) > 0);
+}
+
+void ble_tx_get_stats(ble_tx_stats_t *out) {
+    *out = stats;
+    out->depth = txQueue ? uxQueueMessagesWaiting(txQueue) : 0;
+}
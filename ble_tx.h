@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+class BLECharacteristic;
+
+// Asynchronous watch -> phone transmit queue.
+// Messages are copied into a FreeRTOS queue and sent by a dedicated task, so
+// callers on the UI thread never block on the radio. Long messages are split
+// to the negotiated MTU and pacing follows the stack's congestion events.
+//
+// Interactive commands are held for a short window so superseded ones can be
+// merged (play/pause, opposite volume steps, find-phone start/stop), volume
+// steps in the same direction share one batch entry, and everything collected
+// in the window is packed into as few ATT notifications as the MTU allows.
+#define BLE_TX_QUEUE_LEN      8
+#define BLE_TX_MSG_MAX        256   // JSON bytes per message (without the trailing \r\n)
+#define BLE_TX_COALESCE_MS    150   // how long an interactive command waits for company
+
+// How a message may be merged with others still waiting to be sent
+enum ble_tx_kind_t {
+    BLE_TX_PLAIN = 0,       // sent as is, and flushes the batch immediately
+    BLE_TX_PLAYBACK,        // play/pause: the newest one wins
+    BLE_TX_VOLUME_UP,       // cancels a pending volume down
+    BLE_TX_VOLUME_DOWN,     // cancels a pending volume up
+    BLE_TX_FIND_START,      // cancels a pending find stop
+    BLE_TX_FIND_STOP,       // cancels a pending find start
+    BLE_TX_TRACK,           // next/previous: kept, but batched
+};
+
+struct ble_tx_stats_t {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t dropped;        // queue full or message too long
+    uint32_t fragments;      // ATT notifications sent
+    uint32_t batches;        // radio bursts (one flush line + packed messages)
+    uint32_t coalesced;      // messages merged away before sending
+    uint32_t congestionWaits;
+    uint32_t depth;          // messages waiting right now
+    uint32_t maxDepth;
+    uint32_t latencyAvgUs;   // enqueue -> last fragment handed to the stack
+    uint32_t latencyMaxUs;
+};
+
+void ble_tx_init(BLECharacteristic *txChar);
+
+// Queue one JSON line for the phone. Never blocks; false if it was dropped.
+bool ble_tx_send(const char *json, ble_tx_kind_t kind = BLE_TX_PLAIN);
+
+// Drop anything still queued (e.g. after a disconnect)
+void ble_tx_clear();
+
+// Connection state from the BLE callbacks
+void ble_tx_set_connected(bool connected);
+void ble_tx_set_mtu(uint16_t mtu);
+void ble_tx_set_congested(bool congested);
+
+bool ble_tx_busy();  // messages queued or in flight
+void ble_tx_get_stats(ble_tx_stats_t *stats);
@@ -4,11 +4,21 @@
 #include <BLEUtils.h>
 #include <BLE2902.h>
 #include <ArduinoJson.h>
-#include "mbedtls/base64.h"
+#include <stdarg.h>
+#include <esp_timer.h>
 #include "HWCDC.h"
 #include "rtc_clock.h"
 #include "notification_ui.h"
+#include "notification_store.h"
+#include "notification_log.h"
+#include "notification_dedup.h"
+#include "notification_rules.h"
 #include "power.h"
+#include "spsc_ring.h"
+#include "ble_tx.h"
+#include "ble_conn.h"
+#include "ble_adv.h"
+#include "gb_protocol.h"
 #include <eez/flow/flow.h>
 #include "ui/WizWatch/src/ui/vars.h"
 
@@ -19,6 +29,10 @@ extern HWCDC USBSerial;
 #define CHARACTERISTIC_UUID_RX "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
 #define CHARACTERISTIC_UUID_TX "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
 
+// Compact binary channel: length-prefixed MessagePack (see gb_protocol.h)
+#define BIN_SERVICE_UUID               "7A1E0001-5B1F-4C3E-9A56-2D7F0E3B9C10"
+#define BIN_CHARACTERISTIC_UUID_RX     "7A1E0002-5B1F-4C3E-9A56-2D7F0E3B9C10"
+
 // Device Information Service (DIS) - Gadgetbridge checks this
 #define DIS_SERVICE_UUID                "180A"
 #define DIS_MANUFACTURER_CHAR_UUID      "2A29"
@@ -35,287 +49,444 @@ static BLECharacteristic *pRxCharacteristic = nullptr;
 static bool deviceConnected = false;
 static bool oldDeviceConnected = false;
 
-// Thread-safe receive buffer (callback just appends, main loop processes)
-#define RX_BUF_SIZE 512
-static char rxBuf[RX_BUF_SIZE];
-static volatile int rxBufLen = 0;
+// Lock-free receive ring (BLE callback task produces, protocol task consumes).
+// Sized for 8 full MTU writes so a notification burst fits while the parser is busy.
+#define RX_BUF_SIZE 2048
+
+// Arrival time, ring position and length of each write, so the protocol task can
+// feed the parser one write at a time and time each message from the radio onwards
+struct RxStamp {
+    uint32_t us;
+    uint32_t start;   // ring writePos() of the write's first byte
+    uint32_t len;
+    uint32_t reserved;
+};
+
+// Writes queued beyond this many are still buffered, just fed untimed
+#define RX_STAMP_SLOTS 32
 
-// Line buffer for processing
-static String rxLine = "";
+// One receive path per writable characteristic (NUS text, binary)
+struct RxChannel {
+    explicit RxChannel(bool binary) : binary(binary) {}
+    SpscRing<RX_BUF_SIZE> ring;
+    SpscRing<RX_STAMP_SLOTS * sizeof(RxStamp)> stamps;   // overflows() = untimed writes
+    const bool binary;
+};
+static RxChannel rxText(false);
+static RxChannel rxBinary(true);
+
+// Protocol task: framing, base64 and JSON decoding run next to the BT host on
+// core 0; only the typed events cross over to the UI loop.
+#define PROTO_TASK_STACK     6144
+#define PROTO_TASK_PRIORITY  3
+#define PROTO_TASK_CORE      0
+// How long the parser may wait for the UI to make room before dropping an event
+#define EVENT_QUEUE_WAIT_MS  50
+
+struct QueuedEvent {
+    gb_event_t evt;
+    uint32_t writeUs;      // arrival of the write that completed it, 0 = unknown
+    bool silent;           // notification the rules said to store without showing
+};
+
+// Inbound events are applied by priority: call > find > notify (and the other
+// one-off messages) > music > weather. One-off events get a queue per lane so
+// a call never waits behind a backlog; music and weather are state updates,
+// so they go to a single-slot mailbox where the newest one wins.
+enum EventLane {
+    LANE_CALL = 0,
+    LANE_FIND,
+    LANE_NORMAL,
+    LANE_COUNT,
+};
+static const uint8_t laneDepth[LANE_COUNT] = { 2, 2, 8 };
+static QueueHandle_t eventLanes[LANE_COUNT];
+
+enum EventMailbox {
+    MAILBOX_MUSIC_INFO = 0,
+    MAILBOX_MUSIC_STATE,
+    MAILBOX_WEATHER,
+    MAILBOX_COUNT,
+};
+struct Mailbox {
+    QueuedEvent item;
+    volatile bool pending;
+};
+static Mailbox mailboxes[MAILBOX_COUNT];
+static portMUX_TYPE mailboxLock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t protoTask = nullptr;
+static volatile bool rxResetPending = false;
+static uint32_t eventsDropped = 0;
+static uint32_t eventsCoalesced = 0;    // state updates replaced before the UI applied them
+
+// ---- Telemetry ----
+static const uint32_t latencyBoundsUs[BT_LATENCY_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+static uint32_t rxBytes = 0;
+static uint32_t latencyHist[BT_LATENCY_BUCKETS];
+static uint32_t latencyMaxUs = 0;
+static uint32_t feedWriteUs = 0;       // arrival of the write being parsed (protocol task)
 
 // Data stores
-static bt_notification_t notifications[BT_MAX_NOTIFICATIONS];
-static int notificationCount = 0;
-static int notificationHead = 0; // circular index
 static bt_music_t musicInfo;
 static bt_weather_t weatherInfo;
 static bt_call_t callInfo;
 
 // Forward declarations
-static void handleGBMessage(const String &json);
-static void sendGB(const String &json);
+static void sendGB(const char *json, ble_tx_kind_t kind = BLE_TX_PLAIN);
+
+// Drop buffered bytes and any partial line; done by the protocol task, which owns the parser
+static void requestRxReset() {
+    rxResetPending = true;
+    if (protoTask) xTaskNotifyGive(protoTask);
+}
 
 // Server callbacks
 class MyServerCallbacks: public BLEServerCallbacks {
-    void onConnect(BLEServer* pServer) {
+    void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
         deviceConnected = true;
+        ble_tx_set_connected(true);
+        requestRxReset();
+        ble_adv_connected();
+        ble_conn_connected(param->connect.remote_bda, param->connect.conn_params.interval,
+                           param->connect.conn_params.latency, param->connect.conn_params.timeout);
         USBSerial.println("[BLE] Phone connected!");
     };
 
     void onDisconnect(BLEServer* pServer) {
         deviceConnected = false;
+        ble_tx_set_connected(false);
+        ble_tx_clear();
+        requestRxReset();
+        ble_conn_disconnected();
+        ble_adv_disconnected();
+        power_signal_wake(POWER_WAKE_BLE);  // let a sleeping loop restart advertising
         USBSerial.println("[BLE] Phone disconnected");
     }
+
+    void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+        ble_tx_set_mtu(param->mtu.mtu);
+        USBSerial.printf("[BLE] MTU %u\n", param->mtu.mtu);
+    }
 };
 
-// Receive data from Gadgetbridge — just buffer it, process in main loop
+// Raw GATT server events the Arduino wrapper doesn't surface
+static void gattsEventHandler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param) {
+    if (event == ESP_GATTS_CONGEST_EVT) {
+        ble_tx_set_congested(param->congest.congested);
+    }
+}
+
+// Receive data from Gadgetbridge — just buffer it, the protocol task parses it
 class MyCallbacks: public BLECharacteristicCallbacks {
+public:
+    explicit MyCallbacks(RxChannel *channel) : rx(channel) {}
+
+private:
+    RxChannel *rx;
+
     void onWrite(BLECharacteristic *pCharacteristic) {
         String raw = pCharacteristic->getValue();
-        int len = raw.length();
+        size_t len = raw.length();
         if (len == 0) return;
 
-        // Copy into thread-safe buffer
-        int space = RX_BUF_SIZE - rxBufLen;
-        if (len > space) len = space;
-        if (len > 0) {
-            memcpy(&rxBuf[rxBufLen], raw.c_str(), len);
-            rxBufLen += len;
+        // Never wait here: this runs on the BT host task. Whole write or
+        // nothing, a dropped write is counted by the ring
+        rxBytes += len;
+        // Stamp first: the protocol task may take the bytes as soon as they land.
+        // Room only grows until the push, so the write can't be dropped after its stamp.
+        // With the stamp FIFO full the write goes in untimed.
+        if (rx->ring.space() >= len) {
+            RxStamp stamp = { (uint32_t)esp_timer_get_time(), rx->ring.writePos(), (uint32_t)len, 0 };
+            rx->stamps.push((const uint8_t *)&stamp, sizeof(stamp));
         }
+        rx->ring.push((const uint8_t *)raw.c_str(), len);
+        xTaskNotifyGive(protoTask);
     }
 };
 
-// Process buffered BLE data (called from main loop)
-static void processRxBuffer() {
-    if (rxBufLen == 0) return;
-
-    // Grab data from volatile buffer
-    int len = rxBufLen;
-    char tmp[RX_BUF_SIZE];
-    memcpy(tmp, rxBuf, len);
-    rxBufLen = 0;  // Reset buffer
-
-    // Append to line buffer
-    for (int i = 0; i < len; i++) {
-        char c = tmp[i];
-        if (c == '\n') {
-            rxLine.trim();
-            // Strip leading control characters (Espruino sends \x10 prefix)
-            while (rxLine.length() > 0 && rxLine[0] < 0x20) {
-                rxLine = rxLine.substring(1);
-            }
-            if (rxLine.length() > 0) {
-                USBSerial.print("[BLE] Recv: ");
-                USBSerial.println(rxLine);
-
-                if (rxLine.startsWith("GB(") && rxLine.endsWith(")")) {
-                    String json = rxLine.substring(3, rxLine.length() - 1);
-                    handleGBMessage(json);
-                }
-                // Extract timestamp from setTime(epoch);E.setTimeZone(tz);...
-                else if (rxLine.startsWith("setTime(")) {
-                    int end = rxLine.indexOf(')');
-                    if (end > 8) {
-                        long ts = rxLine.substring(8, end).toInt();
-
-                        // Extract timezone offset (hours) from E.setTimeZone(X.X)
-                        float tz = 0;
-                        int tzStart = rxLine.indexOf("setTimeZone(");
-                        if (tzStart >= 0) {
-                            int tzEnd = rxLine.indexOf(')', tzStart + 12);
-                            if (tzEnd > tzStart + 12) {
-                                tz = rxLine.substring(tzStart + 12, tzEnd).toFloat();
-                            }
-                        }
-
-                        long localTs = ts + (long)(tz * 3600);
-                        USBSerial.printf("[BLE] Time sync: %ld (UTC%+.1f)\n", ts, tz);
-                        rtc_set_from_epoch(localTs);
-                    }
-                }
-            }
-            rxLine = "";
-        } else {
-            rxLine += c;
-        }
-    }
+// Protocol diagnostics go to the USB serial port
+static void gbLog(const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    USBSerial.print(buf);
 }
 
-// Decode base64 from atob() and convert Latin-1 to UTF-8
-static String decodeAtob(const String &b64) {
-    size_t olen;
-    unsigned char decoded[256];
-    int ret = mbedtls_base64_decode(decoded, sizeof(decoded), &olen,
-                                     (const unsigned char*)b64.c_str(), b64.length());
-    if (ret != 0) return "?";
-
-    // Convert Latin-1 to UTF-8, escaping JSON special chars
-    String result;
-    for (size_t i = 0; i < olen; i++) {
-        uint8_t c = decoded[i];
-        if (c < 0x20) continue;  // skip control chars
-        if (c == '"') { result += "\\\""; continue; }
-        if (c == '\\') { result += "\\\\"; continue; }
-        if (c < 0x80) {
-            result += (char)c;
-        } else {
-            // Latin-1 byte to 2-byte UTF-8
-            result += (char)(0xC0 | (c >> 6));
-            result += (char)(0x80 | (c & 0x3F));
-        }
-    }
-    return result;
-}
-
-static void handleGBMessage(const String &json) {
-    // Replace atob("...") with decoded UTF-8 string (Gadgetbridge base64-encodes non-ASCII text)
-    String sanitized = json;
-    int atobPos = 0;
-    while ((atobPos = sanitized.indexOf("atob(\"", atobPos)) >= 0) {
-        int endPos = sanitized.indexOf("\")", atobPos + 6);
-        if (endPos < 0) break;
-        String b64 = sanitized.substring(atobPos + 6, endPos);
-        String decoded = decodeAtob(b64);
-        sanitized = sanitized.substring(0, atobPos) + "\"" + decoded + "\"" + sanitized.substring(endPos + 2);
-        atobPos += decoded.length() + 2;
-    }
-
-    // Convert \xNN hex escapes to actual bytes
-    int pos = 0;
-    while ((pos = sanitized.indexOf("\\x", pos)) >= 0) {
-        if (pos + 3 < (int)sanitized.length()) {
-            char c = (char)strtol(sanitized.substring(pos + 2, pos + 4).c_str(), nullptr, 16);
-            sanitized = sanitized.substring(0, pos) + String(c) + sanitized.substring(pos + 4);
-            pos++;
-        } else {
-            pos += 2;
-        }
+// Turn the screen on for an event worth seeing (black background if it was off)
+static void wakeForEvent() {
+    if (power_is_sleeping()) {
+        notification_ui_set_sleep_bg(true);
+        power_wake();
     }
+    power_reset_inactivity();
+}
 
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, sanitized);
-    if (err) {
-        USBSerial.print("[BLE] JSON parse error: ");
-        USBSerial.println(err.c_str());
-        return;
-    }
-
-    const char* type = doc["t"];
-    if (!type) return;
-
-    USBSerial.print("[BLE] Message type: ");
-    USBSerial.println(type);
-
+// Apply a decoded message from the phone (UI thread, via dispatchEvents). Only
+// notifications, calls and find requests turn the screen on; state updates are
+// applied in the background.
+static void applyEvent(const gb_event_t *evt, bool silent) {
+    switch (evt->kind) {
     // ---- Notification ----
-    if (strcmp(type, "notify") == 0) {
-        bt_notification_t &notif = notifications[notificationHead];
-        notif.id     = doc["id"] | 0;
-        notif.src    = doc["src"] | "Unknown";
-        notif.sender = doc["sender"] | "";
-        notif.title  = doc["title"] | "";
-        notif.body   = doc["body"] | "";
+    case GB_EVT_NOTIFY: {
+        const bt_notification_t &notif = evt->notify;
+        notification_store_add(&notif);
+        notification_log_append(&notif);
 
-        notificationHead = (notificationHead + 1) % BT_MAX_NOTIFICATIONS;
-        if (notificationCount < BT_MAX_NOTIFICATIONS) notificationCount++;
-
-        USBSerial.printf("[BLE] Notification from %s: %s\n",
-            notif.src.c_str(), notif.title.c_str());
+        USBSerial.printf("[BLE] Notification from %s: %s%s\n", notif.src, notif.title, silent ? " (silent)" : "");
+        if (silent) break;
 
         // Show pop-up on watch display and keep screen on
-        power_reset_inactivity();
-        notification_ui_show(notif.src.c_str(), notif.title.c_str(), notif.body.c_str());
+        wakeForEvent();
+        notification_ui_show(notif.src, notif.title, notif.body);
+        break;
     }
     // ---- Dismiss notification ----
-    else if (strcmp(type, "notify-") == 0) {
-        uint32_t id = doc["id"] | 0;
-        for (int i = 0; i < notificationCount; i++) {
-            if (notifications[i].id == id) {
-                notifications[i].id = 0;
-                notifications[i].src = "";
-                notifications[i].title = "";
-                notifications[i].body = "";
-                USBSerial.printf("[BLE] Dismissed notification %d\n", id);
-                break;
-            }
+    case GB_EVT_NOTIFY_DISMISS: {
+        uint32_t id = evt->notify.id;
+        if (notification_store_remove(id)) {
+            USBSerial.printf("[BLE] Dismissed notification %u\n", id);
         }
+        break;
     }
     // ---- Music info ----
-    else if (strcmp(type, "musicinfo") == 0) {
-        musicInfo.artist   = doc["artist"] | "";
-        musicInfo.album    = doc["album"] | "";
-        musicInfo.track    = doc["track"] | "";
-        musicInfo.duration = doc["dur"] | 0;
-        musicInfo.position = doc["c"] | 0;
-        USBSerial.printf("[BLE] Music: %s - %s\n",
-            musicInfo.artist.c_str(), musicInfo.track.c_str());
+    case GB_EVT_MUSIC_INFO: {
+        bool playing = musicInfo.playing;
+        musicInfo = evt->music;
+        musicInfo.playing = playing;
+        USBSerial.printf("[BLE] Music: %s - %s\n", musicInfo.artist, musicInfo.track);
+        break;
     }
     // ---- Music state ----
-    else if (strcmp(type, "musicstate") == 0) {
-        const char* state = doc["state"] | "pause";
-        musicInfo.playing = (strcmp(state, "play") == 0);
+    case GB_EVT_MUSIC_STATE:
+        musicInfo.playing = evt->music.playing;
         USBSerial.printf("[BLE] Music %s\n", musicInfo.playing ? "playing" : "paused");
-    }
+        break;
     // ---- Time sync ----
-    else if (strcmp(type, "setTime") == 0) {
-        long ts = doc["ts"] | 0;
-        if (ts > 0) {
-            USBSerial.printf("[BLE] Time sync: %ld\n", ts);
+    case GB_EVT_SET_TIME:
+        if (evt->time.hasZone) {
+            // From setTime(epoch);E.setTimeZone(tz);... — RTC keeps local time
+            long localTs = evt->time.ts + (long)(evt->time.tzHours * 3600);
+            USBSerial.printf("[BLE] Time sync: %ld (UTC%+.1f)\n", evt->time.ts, evt->time.tzHours);
+            rtc_set_from_epoch(localTs);
+        } else {
+            USBSerial.printf("[BLE] Time sync: %ld\n", evt->time.ts);
             // TODO: update RTC with timestamp
         }
-    }
+        break;
     // ---- Weather ----
-    else if (strcmp(type, "weather") == 0) {
-        weatherInfo.temp     = doc["temp"] | 0;
-        weatherInfo.humidity = doc["hum"] | 0;
-        weatherInfo.txt      = doc["txt"] | "";
-        weatherInfo.code     = doc["code"] | 0;
-        weatherInfo.valid    = true;
-        USBSerial.printf("[BLE] Weather: %d°C %s\n",
-            weatherInfo.temp, weatherInfo.txt.c_str());
-    }
+    case GB_EVT_WEATHER:
+        weatherInfo = evt->weather;
+        USBSerial.printf("[BLE] Weather: %d°C %s\n", weatherInfo.temp, weatherInfo.txt);
+        break;
     // ---- Incoming call ----
-    else if (strcmp(type, "call") == 0) {
-        callInfo.cmd    = doc["cmd"] | "";
-        callInfo.name   = doc["name"] | "";
-        callInfo.number = doc["number"] | "";
-        callInfo.active = (callInfo.cmd == "incoming" || callInfo.cmd == "start");
-        if (callInfo.active) power_reset_inactivity();
-        USBSerial.printf("[BLE] Call: %s from %s\n",
-            callInfo.cmd.c_str(), callInfo.name.c_str());
-    }
+    case GB_EVT_CALL:
+        callInfo = evt->call;
+        if (callInfo.active) wakeForEvent();
+        USBSerial.printf("[BLE] Call: %s from %s\n", callInfo.cmd, callInfo.name);
+        break;
     // ---- Find my watch ----
-    else if (strcmp(type, "find") == 0) {
-        bool on = doc["n"] | false;
-        USBSerial.printf("[BLE] Find: %s\n", on ? "ON" : "OFF");
+    case GB_EVT_FIND:
+        USBSerial.printf("[BLE] Find: %s\n", evt->find ? "ON" : "OFF");
+        if (evt->find) wakeForEvent();
         // TODO: trigger vibration motor or screen flash
-    }
+        break;
     // ---- GPS query ----
-    else if (strcmp(type, "is_gps_active") == 0) {
+    case GB_EVT_GPS_QUERY:
         sendGB("{\"t\":\"gps_power\",\"status\":false}");
+        break;
+    default:
+        break;
     }
-    else {
-        USBSerial.print("[BLE] Unknown type: ");
-        USBSerial.println(type);
+}
+
+// Parse buffered BLE data (protocol task)
+static void processRxBuffer(RxChannel &rx) {
+    char tmp[256];
+    while (!rx.ring.empty()) {
+        // Bytes up to `end` are in; their stamps were queued before them
+        uint32_t pos = rx.ring.readPos();
+        uint32_t end = pos + rx.ring.used();
+        while (pos != end) {
+            // One write at a time, tagged with its arrival time. Bytes ahead of
+            // the next stamp (or with none queued) came in while the stamp FIFO
+            // was full, or raced a reset, and are fed untimed.
+            uint32_t left = end - pos;
+            feedWriteUs = 0;
+            RxStamp stamp;
+            if (rx.stamps.peek((uint8_t *)&stamp, sizeof(stamp)) == sizeof(stamp)) {
+                int32_t ahead = (int32_t)(stamp.start - pos);
+                if (ahead < 0) {
+                    rx.stamps.pop((uint8_t *)&stamp, sizeof(stamp));   // its bytes were cleared
+                    continue;
+                }
+                if (ahead == 0) {
+                    rx.stamps.pop((uint8_t *)&stamp, sizeof(stamp));
+                    feedWriteUs = stamp.us;
+                    if (stamp.len < left) left = stamp.len;
+                } else if ((uint32_t)ahead < left) {
+                    left = ahead;
+                }
+            }
+
+            pos += left;
+            size_t len;
+            while (left > 0 && (len = rx.ring.pop((uint8_t *)tmp, left < sizeof(tmp) ? left : sizeof(tmp))) > 0) {
+                if (rx.binary) gb_protocol_feed_binary((const uint8_t *)tmp, len);
+                else gb_protocol_feed(tmp, len);
+                left -= len;
+            }
+        }
     }
+    feedWriteUs = 0;
 }
 
-// Send JSON to Gadgetbridge (watch -> phone)
-static void sendGB(const String &json) {
+// Protocol-layer sink: hand the event to the UI loop
+static void queueEvent(const gb_event_t *evt) {
+    // Re-sent after a reconnect: drop before it can wake the screen or build a card
+    if (evt->kind == GB_EVT_NOTIFY && !notification_dedup_check(&evt->notify)) return;
+
+    // Rules run here, before anything can wake the screen
+    bool silent = false;
+    if (evt->kind == GB_EVT_NOTIFY) {
+        notif_rule_result_t rule = notification_rules_evaluate(&evt->notify);
+        if (rule == NOTIF_RULE_DROP) return;
+        silent = rule == NOTIF_RULE_SILENT;
+    }
+
+    int mailbox = -1;
+    EventLane lane = LANE_NORMAL;
+    switch (evt->kind) {
+    case GB_EVT_MUSIC_INFO:  mailbox = MAILBOX_MUSIC_INFO; break;
+    case GB_EVT_MUSIC_STATE: mailbox = MAILBOX_MUSIC_STATE; break;
+    case GB_EVT_WEATHER:     mailbox = MAILBOX_WEATHER; break;
+    case GB_EVT_CALL:        lane = LANE_CALL; break;
+    case GB_EVT_FIND:        lane = LANE_FIND; break;
+    default:                 break;
+    }
+
+    if (mailbox >= 0) {
+        Mailbox &box = mailboxes[mailbox];
+        portENTER_CRITICAL(&mailboxLock);
+        if (box.pending) eventsCoalesced++;
+        box.item.evt = *evt;
+        box.item.writeUs = feedWriteUs;
+        box.pending = true;
+        portEXIT_CRITICAL(&mailboxLock);
+    } else {
+        static QueuedEvent item;  // protocol task only
+        item.evt = *evt;
+        item.writeUs = feedWriteUs;
+        item.silent = silent;
+        if (xQueueSend(eventLanes[lane], &item, pdMS_TO_TICKS(EVENT_QUEUE_WAIT_MS)) != pdTRUE) {
+            eventsDropped++;
+            USBSerial.println("[BLE] Event queue full, event dropped");
+            return;
+        }
+        // Only now: a dropped copy must get through when the phone re-sends it
+        if (evt->kind == GB_EVT_NOTIFY) notification_dedup_record(&evt->notify);
+    }
+    power_signal_wake(POWER_WAKE_BLE);
+}
+
+static void protoTaskFn(void *arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (rxResetPending) {
+            rxResetPending = false;
+            for (RxChannel *rx : { &rxText, &rxBinary }) {
+                rx->ring.clear();
+                rx->stamps.clear();
+            }
+            gb_protocol_reset();
+        }
+        processRxBuffer(rxText);
+        processRxBuffer(rxBinary);
+    }
+}
+
+static void recordLatency(uint32_t us) {
+    int bucket = 0;
+    while (bucket < BT_LATENCY_BUCKETS - 1 && us >= latencyBoundsUs[bucket]) bucket++;
+    latencyHist[bucket]++;
+    if (us > latencyMaxUs) latencyMaxUs = us;
+}
+
+static void dispatchOne(const QueuedEvent *item) {
+    applyEvent(&item->evt, item->silent);
+    if (item->writeUs) recordLatency((uint32_t)esp_timer_get_time() - item->writeUs);
+}
+
+// Apply pending events on the UI thread, highest priority first, and record
+// how long each took from the write that completed it
+static void dispatchEvents() {
+    static QueuedEvent item;
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        // Only what was queued when this lane started, so a stream of
+        // low-priority events can't keep the loop here
+        UBaseType_t count = uxQueueMessagesWaiting(eventLanes[lane]);
+        while (count-- > 0 && xQueueReceive(eventLanes[lane], &item, 0) == pdTRUE) {
+            dispatchOne(&item);
+            // Anything urgent that arrived meanwhile goes next
+            while (lane > LANE_CALL && xQueueReceive(eventLanes[LANE_CALL], &item, 0) == pdTRUE) {
+                dispatchOne(&item);
+            }
+        }
+    }
+
+    // Newest music and weather state, at most once each per frame
+    for (Mailbox &box : mailboxes) {
+        if (!box.pending) continue;
+        portENTER_CRITICAL(&mailboxLock);
+        item = box.item;
+        box.pending = false;
+        portEXIT_CRITICAL(&mailboxLock);
+        dispatchOne(&item);
+    }
+}
+
+static bool eventsPending() {
+    for (QueueHandle_t q : eventLanes) {
+        if (uxQueueMessagesWaiting(q) > 0) return true;
+    }
+    for (const Mailbox &box : mailboxes) {
+        if (box.pending) return true;
+    }
+    return false;
+}
+
+// Send JSON to Gadgetbridge (watch -> phone); queued, never blocks the UI
+static void sendGB(const char *json, ble_tx_kind_t kind) {
     if (!deviceConnected) return;
-    // Send empty line first to flush any pending REPL state (like real Bangle.js)
-    String flush = "\r\n";
-    pTxCharacteristic->setValue(flush.c_str());
-    pTxCharacteristic->notify();
-    delay(20);
-    // Send the actual JSON
-    String msg = json + "\r\n";
-    pTxCharacteristic->setValue(msg.c_str());
-    pTxCharacteristic->notify();
+    if (ble_tx_send(json, kind)) ble_conn_boost();
+}
+
+// Built-in message types; extra ones are added on top before the protocol task starts
+static void initProtocol() {
+    static bool initialized = false;
+    if (initialized) return;
+    gb_protocol_init(queueEvent, gbLog);
+    initialized = true;
 }
 
 void bluetooth_init() {
     USBSerial.println("[BLE] Initializing Bluetooth...");
 
+    initProtocol();
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        eventLanes[lane] = xQueueCreate(laneDepth[lane], sizeof(QueuedEvent));
+    }
+    // History from before the reboot, before the protocol task can touch the dedup list
+    notification_store_init();
+    notification_log_restore(NOTIF_LOG_RESTORE);
+    xTaskCreatePinnedToCore(protoTaskFn, "ble_proto", PROTO_TASK_STACK, nullptr,
+                            PROTO_TASK_PRIORITY, &protoTask, PROTO_TASK_CORE);
+
     // Name MUST start with "Bangle.js" for Gadgetbridge to recognize it
     BLEDevice::init("Bangle.js WizWatch");
 
@@ -328,6 +499,9 @@ void bluetooth_init() {
     pSecurity->setCapability(ESP_IO_CAP_NONE);
     pSecurity->setAuthenticationMode(ESP_LE_AUTH_BOND);
 
+    BLEDevice::setCustomGattsHandler(gattsEventHandler);
+    ble_conn_init();
+
     pServer = BLEDevice::createServer();
     pServer->setCallbacks(new MyServerCallbacks());
 
@@ -340,39 +514,47 @@ void bluetooth_init() {
         BLECharacteristic::PROPERTY_NOTIFY
     );
     pTxCharacteristic->addDescriptor(new BLE2902());
+    ble_tx_init(pTxCharacteristic);
 
     // RX: Phone -> Watch (write)
     pRxCharacteristic = pService->createCharacteristic(
         CHARACTERISTIC_UUID_RX,
         BLECharacteristic::PROPERTY_WRITE
     );
-    pRxCharacteristic->setCallbacks(new MyCallbacks());
+    pRxCharacteristic->setCallbacks(new MyCallbacks(&rxText));
 
     pService->start();
 
+    // --- Binary channel (optional; Gadgetbridge itself only uses NUS) ---
+    BLEService *pBinService = pServer->createService(BIN_SERVICE_UUID);
+    BLECharacteristic *pBinRxCharacteristic = pBinService->createCharacteristic(
+        BIN_CHARACTERISTIC_UUID_RX,
+        BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR
+    );
+    pBinRxCharacteristic->setCallbacks(new MyCallbacks(&rxBinary));
+    pBinService->start();
+
     BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
     pAdvertising->addServiceUUID(SERVICE_UUID);
     pAdvertising->setScanResponse(true);
-    // Advertising interval: 20-40ms (fast discovery, ~1mA more than default)
-    // Units are 0.625ms, so 0x20=20ms, 0x40=40ms
-    pAdvertising->setMinInterval(0x20);
-    pAdvertising->setMaxInterval(0x40);
-    // Preferred connection interval once connected
+    // Start at the fast advertising interval; ble_adv backs off from there
+    pAdvertising->setMinInterval(BLE_ADV_FAST_MIN);
+    pAdvertising->setMaxInterval(BLE_ADV_FAST_MAX);
+    // Preferred connection interval once connected (ble_conn adjusts it to the power state)
     pAdvertising->setMinPreferred(0x06);
     pAdvertising->setMaxPreferred(0x12);
     BLEDevice::startAdvertising();
+    ble_adv_init();
 
     USBSerial.println("[BLE] Ready as 'Bangle.js WizWatch'");
 }
 
 void bluetooth_update() {
-    // Process any received BLE data
-    processRxBuffer();
+    // Apply whatever the protocol task has decoded
+    dispatchEvents();
 
     if (!deviceConnected && oldDeviceConnected) {
-        // Clean up after disconnect
-        rxBufLen = 0;
-        rxLine = "";
+        // Clean up after disconnect (buffers were reset by the protocol task)
         oldDeviceConnected = false;
         eez::flow::setGlobalVariable(FLOW_GLOBAL_VARIABLE_PHONE_CONNECTED_VAR, eez::Value(1));
         USBSerial.println("[BLE] Cleaning up connection...");
@@ -384,16 +566,14 @@ void bluetooth_update() {
         disconnectTime = millis();
     }
     if (disconnectTime > 0 && !deviceConnected && (millis() - disconnectTime > 500)) {
-        BLEDevice::startAdvertising();
+        ble_adv_start();
         USBSerial.println("[BLE] Restarting advertising");
         disconnectTime = 0;
         oldDeviceConnected = false;  // ready for next connect
     }
 
     if (deviceConnected && !oldDeviceConnected) {
-        // Fresh connection — clear buffers
-        rxBufLen = 0;
-        rxLine = "";
+        // Fresh connection
         disconnectTime = 0;
         oldDeviceConnected = true;
         eez::flow::setGlobalVariable(FLOW_GLOBAL_VARIABLE_PHONE_CONNECTED_VAR, eez::Value(0));
@@ -411,31 +591,124 @@ bool bluetooth_is_connected() {
 }
 
 bool bluetooth_has_pending_data() {
-    return rxBufLen > 0;
+    return eventsPending();
+}
+
+uint32_t bluetooth_rx_overflows() {
+    return rxText.ring.overflows() + rxBinary.ring.overflows();
+}
+
+bool bluetooth_tx_busy() {
+    return ble_tx_busy();
+}
+
+uint32_t bluetooth_json_heap_allocs() {
+    gb_protocol_stats_t stats;
+    gb_protocol_get_stats(&stats);
+    return stats.heapAllocs;
+}
+
+void bluetooth_get_telemetry(bt_telemetry_t *out) {
+    out->rxBytes = rxBytes;
+    out->rxDroppedBytes = rxText.ring.droppedBytes() + rxBinary.ring.droppedBytes();
+    out->rxDroppedWrites = rxText.ring.overflows() + rxBinary.ring.overflows();
+    out->rxUntimedWrites = rxText.stamps.overflows() + rxBinary.stamps.overflows();
+    out->eventsDropped = eventsDropped;
+    out->eventsCoalesced = eventsCoalesced;
+    out->dedupHits = notification_dedup_hits();
+    out->dedupMisses = notification_dedup_misses();
+    notification_rules_get_stats(&out->rules);
+    gb_protocol_get_stats(&out->protocol);
+    memcpy(out->latency, latencyHist, sizeof(latencyHist));
+    out->latencyMaxUs = latencyMaxUs;
+}
+
+static size_t appendf(char *buf, size_t size, size_t len, const char *fmt, ...) {
+    if (len >= size) return len;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + len, size - len, fmt, args);
+    va_end(args);
+    return n < 0 ? len : (len + n < size ? len + n : size - 1);
+}
+
+size_t bluetooth_format_telemetry(char *buf, size_t size) {
+    if (size == 0) return 0;
+    buf[0] = '\0';
+
+    bt_telemetry_t t;
+    bluetooth_get_telemetry(&t);
+    const gb_protocol_stats_t &p = t.protocol;
+    size_t n = 0;
+
+    n = appendf(buf, size, n, "RX %lu B, dropped %lu B (%lu writes), %lu writes untimed\n",
+        t.rxBytes, t.rxDroppedBytes, t.rxDroppedWrites, t.rxUntimedWrites);
+    n = appendf(buf, size, n, "Events dropped %lu, coalesced %lu; notify dedup %lu hits, %lu misses\n",
+        t.eventsDropped, t.eventsCoalesced, t.dedupHits, t.dedupMisses);
+    n = appendf(buf, size, n, "Rules: shown %lu, quiet %lu, rate limited %lu, dropped %lu\n",
+        t.rules.shown, t.rules.quiet, t.rules.rateLimited, t.rules.dropped);
+    n = appendf(buf, size, n, "Lines %lu (%lu overlong), frames %lu (%lu overlong), msgs %lu, oversized %lu, unknown %lu\n",
+        p.lines, p.overlong, p.binFrames, p.binOverlong, p.messages, p.oversized, p.unknownTypes);
+
+    n = appendf(buf, size, n, "Parse errors %lu:", p.parseErrors);
+    for (int code = 1; code < GB_PARSE_ERROR_CODES; code++) {
+        n = appendf(buf, size, n, " %s %lu",
+            DeserializationError((DeserializationError::Code)code).c_str(), p.parseErrorsByCode[code]);
+    }
+
+    n = appendf(buf, size, n, "\nTypes:");
+    for (size_t slot = 0; slot < GB_TYPE_SLOTS; slot++) {
+        const gb_type_t *type = gb_type_at(slot);
+        if (type && type->received) n = appendf(buf, size, n, " %s %lu", type->def->type, type->received);
+    }
+
+    n = appendf(buf, size, n, "\nLatency (ms):");
+    for (int i = 0; i < BT_LATENCY_BUCKETS; i++) {
+        if (i < BT_LATENCY_BUCKETS - 1) n = appendf(buf, size, n, " <%lu:%lu", latencyBoundsUs[i] / 1000, t.latency[i]);
+        else n = appendf(buf, size, n, " more:%lu", t.latency[i]);
+    }
+    n = appendf(buf, size, n, " max %lu.%lu\n", t.latencyMaxUs / 1000, t.latencyMaxUs % 1000 / 100);
+
+    ble_tx_stats_t tx;
+    ble_tx_get_stats(&tx);
+    n = appendf(buf, size, n, "TX sent %lu, dropped %lu, merged %lu, avg %lu us, max %lu us\n",
+        tx.sent, tx.dropped, tx.coalesced, tx.latencyAvgUs, tx.latencyMaxUs);
+
+    ble_conn_stats_t conn;
+    ble_conn_get_stats(&conn);
+    n = appendf(buf, size, n, "Conn %u x1.25 ms, lat %u, fast %lu s, slow %lu s\n",
+        conn.interval, conn.latency, conn.fastMs / 1000, conn.slowMs / 1000);
+
+    ble_adv_stats_t adv;
+    ble_adv_get_stats(&adv);
+    n = appendf(buf, size, n, "Adv %lu s (%lu s fast), reconnect avg %lu ms, max %lu ms\n",
+        adv.advertisingMs / 1000, adv.fastMs / 1000, adv.reconnectAvgMs, adv.reconnectMaxMs);
+    return n;
 }
 
 void bluetooth_sleep() {
-    BLEDevice::getAdvertising()->stop();
-    USBSerial.println("[BLE] Advertising stopped (sleep)");
+    // Advertising keeps running and backs off on its own, so the phone can
+    // still reconnect while the screen is off
+    ble_conn_set_mode(BLE_CONN_SLOW);
 }
 
 void bluetooth_wake() {
-    if (!deviceConnected) {
-        BLEDevice::getAdvertising()->start();
-        USBSerial.println("[BLE] Advertising resumed");
-    }
+    ble_conn_set_mode(BLE_CONN_FAST);
+    bluetooth_user_activity();
+}
+
+void bluetooth_user_activity() {
+    if (!deviceConnected) ble_adv_interaction();
 }
 
 // --- Data accessors ---
 
-const bt_notification_t* bluetooth_get_latest_notification() {
-    if (notificationCount == 0) return nullptr;
-    int idx = (notificationHead - 1 + BT_MAX_NOTIFICATIONS) % BT_MAX_NOTIFICATIONS;
-    return &notifications[idx];
+bool bluetooth_get_latest_notification(notif_view_t *out) {
+    return notification_store_get(0, out);
 }
 
 int bluetooth_get_notification_count() {
-    return notificationCount;
+    return notification_store_count();
 }
 
 const bt_music_t* bluetooth_get_music() {
@@ -456,9 +729,19 @@ void bluetooth_send_music_command(const char* cmd) {
     JsonDocument doc;
     doc["t"] = "music";
     doc["n"] = cmd;
-    String json;
-    serializeJson(doc, json);
-    sendGB(json);
+    char json[64];
+    serializeJson(doc, json, sizeof(json));
+
+    // Let the TX queue merge rapid presses that supersede each other
+    ble_tx_kind_t kind = BLE_TX_TRACK;
+    if (strcmp(cmd, "play") == 0 || strcmp(cmd, "pause") == 0) {
+        kind = BLE_TX_PLAYBACK;
+    } else if (strcmp(cmd, "volumeup") == 0) {
+        kind = BLE_TX_VOLUME_UP;
+    } else if (strcmp(cmd, "volumedown") == 0) {
+        kind = BLE_TX_VOLUME_DOWN;
+    }
+    sendGB(json, kind);
     USBSerial.printf("[BLE] Music cmd: %s\n", cmd);
 }
 
@@ -466,18 +749,22 @@ void bluetooth_dismiss_notification(uint32_t id) {
     JsonDocument doc;
     doc["t"] = "notify-";
     doc["id"] = id;
-    String json;
-    serializeJson(doc, json);
+    char json[64];
+    serializeJson(doc, json, sizeof(json));
     sendGB(json);
 
     // Also remove locally
-    for (int i = 0; i < notificationCount; i++) {
-        if (notifications[i].id == id) {
-            notifications[i].id = 0;
-            notifications[i].src = "";
-            break;
-        }
+    notification_store_remove(id);
+}
+
+bool bluetooth_register_message(const gb_type_def_t *def) {
+    // The type table is read by the protocol task without a lock
+    if (protoTask) {
+        USBSerial.printf("[BLE] Type %s must be registered before bluetooth_init()\n", def->type);
+        return false;
     }
+    initProtocol();
+    return gb_register_type(def);
 }
 
 void bluetooth_answer_call() {
@@ -492,9 +779,9 @@ void bluetooth_reject_call() {
 
 void bluetooth_find_phone(bool start) {
     if (start) {
-        sendGB("{\"t\":\"findPhone\",\"n\":true}");
+        sendGB("{\"t\":\"findPhone\",\"n\":true}", BLE_TX_FIND_START);
     } else {
-        sendGB("{\"t\":\"findPhone\",\"n\":false}");
+        sendGB("{\"t\":\"findPhone\",\"n\":false}", BLE_TX_FIND_STOP);
     }
     USBSerial.printf("[BLE] Find phone: %s\n", start ? "START" : "STOP");
 }
@@ -1,45 +1,9 @@
 #pragma once
 
 #include <Arduino.h>
-
-// Max stored notifications
-#define BT_MAX_NOTIFICATIONS 5
-
-// Notification from phone
-struct bt_notification_t {
-    uint32_t id;
-    String src;     // App name (e.g. "WhatsApp")
-    String sender;
-    String title;
-    String body;
-};
-
-// Music playback info
-struct bt_music_t {
-    String artist;
-    String album;
-    String track;
-    int duration;   // seconds
-    int position;   // seconds
-    bool playing;
-};
-
-// Weather info
-struct bt_weather_t {
-    int temp;       // Celsius
-    int humidity;
-    String txt;     // Description ("Sunny", "Cloudy", etc.)
-    int code;       // Weather code
-    bool valid;
-};
-
-// Call state
-struct bt_call_t {
-    String cmd;     // "incoming", "accept", "reject", "start", "end"
-    String name;
-    String number;
-    bool active;
-};
+#include "gb_protocol.h"
+#include "notification_store.h"
+#include "notification_rules.h"
 
 // Bluetooth initialization and control
 void bluetooth_init();
@@ -50,15 +14,47 @@ bool bluetooth_is_connected();
 // Power management
 void bluetooth_sleep();
 void bluetooth_wake();
-bool bluetooth_has_pending_data();  // True if BLE data waiting to be processed
+void bluetooth_user_activity();     // Touch etc.: advertise fast again if disconnected
+bool bluetooth_has_pending_data();  // True if decoded events are waiting for bluetooth_update()
+uint32_t bluetooth_rx_overflows();  // Writes dropped because the receive ring was full
+bool bluetooth_tx_busy();            // Outbound messages queued or being sent
+uint32_t bluetooth_json_heap_allocs();  // Heap allocations made while decoding messages (should stay 0)
+
+// Telemetry
+#define BT_LATENCY_BUCKETS 8   // write -> dispatched: <1, <2, <5, <10, <20, <50, <100 ms, more
+
+struct bt_telemetry_t {
+    uint32_t rxBytes;          // bytes written by the phone
+    uint32_t rxDroppedBytes;   // lost because the receive ring was full
+    uint32_t rxDroppedWrites;
+    uint32_t rxUntimedWrites;  // buffered while all stamp slots were taken, no latency sample
+    uint32_t eventsDropped;    // decoded events the UI queue had no room for
+    uint32_t eventsCoalesced;  // music/weather updates superseded before they were applied
+    uint32_t dedupHits;        // notifications dropped as already seen
+    uint32_t dedupMisses;
+    notif_rules_stats_t rules;
+    gb_protocol_stats_t protocol;
+    uint32_t latency[BT_LATENCY_BUCKETS];
+    uint32_t latencyMaxUs;
+};
+
+void bluetooth_get_telemetry(bt_telemetry_t *t);
+// Human-readable summary of the BLE path (RX, protocol, TX, link), for serial and the diagnostics screen
+size_t bluetooth_format_telemetry(char *buf, size_t size);
 
 // Data accessors
-const bt_notification_t* bluetooth_get_latest_notification();
+bool bluetooth_get_latest_notification(notif_view_t *out);
 int bluetooth_get_notification_count();
 const bt_music_t* bluetooth_get_music();
 const bt_weather_t* bluetooth_get_weather();
 const bt_call_t* bluetooth_get_call();
 
+// Handle an additional Gadgetbridge message type (alarms, activity fetch, ...).
+// Call before bluetooth_init(); `def` must be static. Returns false after
+// bluetooth_init(), for a name of GB_TYPE_NAME_MAX or more, or if the type
+// exists or the table is full.
+bool bluetooth_register_message(const gb_type_def_t *def);
+
 // Actions (watch -> phone)
 void bluetooth_send_music_command(const char* cmd); // "play", "pause", "next", "previous", "volumeup", "volumedown"
 void bluetooth_dismiss_notification(uint32_t id);
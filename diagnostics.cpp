@@ -0,0 +1,106 @@
+#include "diagnostics.h"
+#include <lvgl.h>
+#include "HWCDC.h"
+#include "bluetooth.h"
+#include "power.h"
+#include "display_bench.h"
+#include "perf.h"
+#include "ui/WizWatch/src/ui/fonts.h"
+#include "ui/WizWatch/src/ui/screens.h"
+
+extern HWCDC USBSerial;
+
+#define DIAG_TEXT_MAX     1024
+#define DIAG_REFRESH_MS   1000
+#define DIAG_CMD_MAX      32
+
+static char text[DIAG_TEXT_MAX];
+static char cmd[DIAG_CMD_MAX];
+static size_t cmdLen = 0;
+
+static lv_obj_t *panel = nullptr;
+static lv_obj_t *label = nullptr;
+static lv_timer_t *refreshTimer = nullptr;
+
+static void refresh_cb(lv_timer_t *timer) {
+    bluetooth_format_telemetry(text, sizeof(text));
+    lv_label_set_text(label, text);
+    // Keep the screen on while someone is reading it
+    power_reset_inactivity();
+}
+
+static void close_cb(lv_event_t *e) {
+    lv_timer_delete(refreshTimer);
+    refreshTimer = nullptr;
+    lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void open_cb(lv_event_t *e) {
+    if (refreshTimer) return;
+    lv_obj_remove_flag(panel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_foreground(panel);
+    refreshTimer = lv_timer_create(refresh_cb, DIAG_REFRESH_MS, nullptr);
+    refresh_cb(refreshTimer);
+}
+
+void diagnostics_init() {
+    panel = lv_obj_create(lv_layer_top());
+    lv_obj_set_pos(panel, 0, 0);
+    lv_obj_set_size(panel, 410, 502);
+    lv_obj_set_style_bg_color(panel, lv_color_black(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(panel, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_width(panel, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(panel, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(panel, 20, LV_PART_MAIN);
+    lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(panel, close_cb, LV_EVENT_CLICKED, nullptr);
+
+    label = lv_label_create(panel);
+    lv_obj_set_width(label, lv_pct(100));
+    lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
+    lv_obj_set_style_text_font(label, &ui_font_dot_gothic16_14, LV_PART_MAIN);
+    lv_obj_set_style_text_color(label, lv_color_hex(0xb4e898), LV_PART_MAIN);
+
+    // Hidden entry point: long-press the clock
+    lv_obj_add_flag(objects.time_lbl, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(objects.time_lbl, open_cb, LV_EVENT_LONG_PRESSED, nullptr);
+}
+
+static void runCommand(const char *line) {
+    if (strcmp(line, "stats") == 0) {
+        bluetooth_format_telemetry(text, sizeof(text));
+        USBSerial.print(text);
+    } else if (strcmp(line, "flush") == 0) {
+        display_format_flush_stats(text, sizeof(text));
+        USBSerial.print(text);
+    } else if (strcmp(line, "bench") == 0 || strcmp(line, "bench sweep") == 0) {
+        if (power_is_sleeping()) {
+            USBSerial.println("[DIAG] Wake the screen first");
+            return;
+        }
+        display_bench_run(lv_display_get_default(), line[5] ? DISPLAY_BENCH_SWEEP : DISPLAY_BENCH_ON);
+        power_reset_inactivity();
+#ifdef WIZWATCH_PERF
+    } else if (strcmp(line, "perf") == 0) {
+        perf_format(text, sizeof(text));
+        USBSerial.print(text);
+    } else if (strcmp(line, "perf overlay") == 0) {
+        perf_overlay_toggle();
+#endif
+    } else if (line[0]) {
+        USBSerial.printf("[DIAG] Unknown command '%s' (try: stats, flush, bench, bench sweep)\n", line);
+    }
+}
+
+void diagnostics_poll() {
+    while (USBSerial.available() > 0) {
+        char c = USBSerial.read();
+        if (c == '\r' || c == '\n') {
+            cmd[cmdLen] = '\0';
+            runCommand(cmd);
+            cmdLen = 0;
+        } else if (cmdLen < DIAG_CMD_MAX - 1) {
+            cmd[cmdLen++] = c;
+        }
+    }
+}
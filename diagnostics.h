@@ -0,0 +1,10 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Field diagnostics: BLE telemetry on demand.
+// - Serial: type "stats" on the USB console; "flush" prints display flush
+//   totals; "bench" / "bench sweep" run the frame benchmark (display_bench.h).
+// - Screen: long-press the clock on the main screen; tap the panel to close.
+void diagnostics_init();   // call after ui_init
+void diagnostics_poll();   // call from loop; reads serial commands
@@ -1,5 +1,20 @@
 #include "display.h"
 #include "HWCDC.h"
+#include "sd_card.h"
+#include "perf.h"
+#include <SD_MMC.h>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+
+// The coalescer edits LVGL's invalidated-area list in place
+#if __has_include("src/display/lv_display_private.h")
+#include "src/display/lv_display_private.h"
+#else
+#include "display/lv_display_private.h"
+#endif
 
 extern HWCDC USBSerial;
 
@@ -10,15 +25,310 @@ Arduino_GFX *gfx = new Arduino_CO5300(bus, LCD_RESET,
                                       0, LCD_WIDTH, LCD_HEIGHT,
                                       22, 0, 0, 0);
 
-void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
-#ifndef DIRECT_RENDER_MODE
-  uint32_t w = lv_area_get_width(area);
-  uint32_t h = lv_area_get_height(area);
-  gfx->draw16bitRGBBitmap(area->x1, area->y1, (uint16_t *)px_map, w, h);
+// Flush task: pushes finished bands over QSPI while LVGL renders the next one
+// into the other draw buffer
+#define FLUSH_TASK_STACK     3072
+#define FLUSH_TASK_PRIORITY  4
+#define FLUSH_TASK_CORE      0
+
+// Direct mode: dirty rows are gathered from the framebuffer into a contiguous
+// staging band of this height before being sent
+#define DIRECT_STAGE_LINES   20
+
+#ifdef DIRECT_RENDER_MODE
+#define DISPLAY_DEFAULT_MODE DISPLAY_MODE_DIRECT
+#else
+#define DISPLAY_DEFAULT_MODE DISPLAY_MODE_PARTIAL
 #endif
+
+struct FlushJob {
+  lv_display_t *disp;
+  lv_area_t area;
+  uint8_t *px_map;
+};
+
+static QueueHandle_t flushQueue = nullptr;
+static SemaphoreHandle_t flushDone = nullptr;
+static SemaphoreHandle_t busLock = nullptr;   // one user of the panel bus at a time
+static volatile bool flushPending = false;
+static bool asyncFlush = false;
+static display_flush_stats_t flushStats;
+
+static display_config_t config = { DISPLAY_DEFAULT_MODE, DRAW_BUF_LINES, 2, DISPLAY_WINDOW_COST_PX, true, DISPLAY_BENCH_OFF };
+static uint8_t *drawBuf[2] = { nullptr, nullptr };
+static uint16_t *stageBuf = nullptr;
+
+static void drawArea(int32_t x, int32_t y, uint32_t w, uint32_t h, uint8_t *px_map) {
+  int64_t start = esp_timer_get_time();
+  PERF_BEGIN(PERF_FLUSH);
+
+  if (busLock) xSemaphoreTake(busLock, portMAX_DELAY);
+  gfx->draw16bitRGBBitmap(x, y, (uint16_t *)px_map, w, h);
+  if (busLock) xSemaphoreGive(busLock);
+
+  PERF_END(PERF_FLUSH);
+
+  flushStats.flushes++;
+  flushStats.bytes += w * h * 2;
+  flushStats.busyUs += esp_timer_get_time() - start;
+}
+
+// Panel shadow: one bit per SHADOW_CELL_PX-wide cell of each row, set while
+// the panel is known to show black there. display_init() clears the panel,
+// so everything starts black.
+#define SHADOW_CELL_PX  8
+#define SHADOW_CELLS    ((LCD_WIDTH + SHADOW_CELL_PX - 1) / SHADOW_CELL_PX)
+#define SHADOW_WORDS    ((SHADOW_CELLS + 31) / 32)
+
+static uint32_t panelBlack[LCD_HEIGHT][SHADOW_WORDS];
+
+// Per-row scan results for the band being flushed (one flusher at a time)
+static uint16_t rowLead[LCD_HEIGHT];    // black pixels from the left
+static uint16_t rowTrail[LCD_HEIGHT];   // black pixels from the right
+static bool pairSkip[LCD_HEIGHT / 2];
+
+struct RowRun {
+  uint16_t first;   // first row pair
+  uint16_t end;     // one past the last row pair
+};
+static RowRun runs[LCD_HEIGHT / 4 + 1];
+
+static void shadowFill(bool black) {
+  memset(panelBlack, black ? 0xff : 0, sizeof(panelBlack));
+}
+
+// Every cell touching [x1, x2] of the row is known black
+static bool shadowBlack(int32_t row, int32_t x1, int32_t x2) {
+  for (int32_t c = x1 / SHADOW_CELL_PX; c <= x2 / SHADOW_CELL_PX; c++) {
+    if (!(panelBlack[row][c / 32] & (1u << (c % 32)))) return false;
+  }
+  return true;
+}
+
+// Record what one row of [x1, x2] now shows. A partly covered cell can only
+// stay black, never become black.
+static void shadowUpdate(int32_t row, int32_t x1, int32_t x2, const uint16_t *px) {
+  for (int32_t c = x1 / SHADOW_CELL_PX; c <= x2 / SHADOW_CELL_PX; c++) {
+    int32_t cellStart = c * SHADOW_CELL_PX;
+    int32_t cellEnd = min<int32_t>(cellStart + SHADOW_CELL_PX - 1, LCD_WIDTH - 1);
+    int32_t from = max<int32_t>(cellStart, x1);
+    int32_t to = min<int32_t>(cellEnd, x2);
+
+    bool black = true;
+    for (int32_t x = from; x <= to && black; x++) {
+      black = px[x - x1] == 0;
+    }
+    uint32_t bit = 1u << (c % 32);
+    bool covered = from == cellStart && to == cellEnd;
+    if (black && (covered || (panelBlack[row][c / 32] & bit))) {
+      panelBlack[row][c / 32] |= bit;
+    } else {
+      panelBlack[row][c / 32] &= ~bit;
+    }
+  }
+}
+
+static void sendRect(int32_t x, int32_t y, uint32_t w, uint32_t h, uint16_t *px) {
+  drawArea(x, y, w, h, (uint8_t *)px);
+  for (uint32_t r = 0; r < h; r++) {
+    shadowUpdate(y + r, x, x + w - 1, px + r * w);
+  }
+}
+
+// Send rows [r0, r1) of the band, trimming columns that are black in the
+// buffer and already black on the panel. Compacts the rows in place.
+static void sendRun(int32_t x, int32_t y, uint32_t w, uint32_t r0, uint32_t r1, uint16_t *px) {
+  uint32_t lead = w, trail = w;
+  for (uint32_t r = r0; r < r1; r++) {
+    lead = min<uint32_t>(lead, rowLead[r]);
+    trail = min<uint32_t>(trail, rowTrail[r]);
+  }
+  lead &= ~1u;   // CO5300 windows start on even columns...
+  trail &= ~1u;  // ...and are an even number wide
+  if (lead + trail >= w) lead = trail = 0;  // fully black rows that still need sending
+  for (uint32_t r = r0; r < r1 && (lead || trail); r++) {
+    if (lead && !shadowBlack(y + r, x, x + lead - 1)) lead = 0;
+    if (trail && !shadowBlack(y + r, x + w - trail, x + w - 1)) trail = 0;
+  }
+
+  uint16_t *rows = px + r0 * w;
+  uint32_t sendW = w - lead - trail;
+  if (sendW != w) {
+    for (uint32_t r = 0; r < r1 - r0; r++) {
+      memmove(rows + r * sendW, rows + r * w + lead, sendW * 2);
+    }
+    flushStats.skippedBytes += (w - sendW) * (r1 - r0) * 2;
+  }
+  sendRect(x + lead, y + r0, sendW, r1 - r0, rows);
+}
+
+// Flush one contiguous band (caller-owned, may be modified). Row pairs that
+// are black and already black on the panel are skipped when separate
+// windows cost less than sending through them; see DISPLAY_WINDOW_COST_PX.
+static void flushBand(int32_t x, int32_t y, uint32_t w, uint32_t h, uint16_t *px) {
+  if (!config.blackSkip || ((x | y | w | h) & 1)) {
+    sendRect(x, y, w, h, px);
+    return;
+  }
+
+  uint32_t pairs = h / 2;
+  for (uint32_t r = 0; r < h; r++) {
+    const uint16_t *row = px + r * w;
+    uint32_t lead = 0;
+    while (lead < w && row[lead] == 0) lead++;
+    uint32_t trail = 0;
+    while (trail < w - lead && row[w - 1 - trail] == 0) trail++;
+    rowLead[r] = lead;
+    rowTrail[r] = trail;
+  }
+  for (uint32_t k = 0; k < pairs; k++) {
+    pairSkip[k] = rowLead[2 * k] == w && rowLead[2 * k + 1] == w &&
+                  shadowBlack(y + 2 * k, x, x + w - 1) &&
+                  shadowBlack(y + 2 * k + 1, x, x + w - 1);
+  }
+
+  // Runs of rows to send; bridge gaps that cost less than a window
+  uint32_t runCount = 0;
+  uint32_t pxPerPair = w * 2;
+  for (uint32_t k = 0; k < pairs; k++) {
+    if (pairSkip[k]) continue;
+    if (runCount && (k - runs[runCount - 1].end) * pxPerPair < config.windowCost) {
+      runs[runCount - 1].end = k + 1;
+    } else {
+      runs[runCount++] = { (uint16_t)k, (uint16_t)(k + 1) };
+    }
+  }
+
+  if (runCount == 0) {
+    flushStats.skippedBytes += w * h * 2;
+    return;
+  }
+
+  // Split only if the windows it adds are paid for by the rows it skips
+  uint32_t splitCost = 0;
+  for (uint32_t i = 0; i < runCount; i++) {
+    splitCost += config.windowCost + (runs[i].end - runs[i].first) * pxPerPair;
+  }
+  if (splitCost >= config.windowCost + w * h) {
+    runs[0] = { 0, (uint16_t)pairs };
+    runCount = 1;
+  }
+
+  uint32_t sentPairs = 0;
+  for (uint32_t i = 0; i < runCount; i++) {
+    sendRun(x, y, w, runs[i].first * 2, runs[i].end * 2, px);
+    sentPairs += runs[i].end - runs[i].first;
+  }
+  flushStats.skippedBytes += (pairs - sentPairs) * pxPerPair * 2;
+}
+
+// px_map is the whole framebuffer; send only the dirty rectangle
+static void drawDirect(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
+  uint32_t w = lv_area_get_width(area);
+  uint32_t stride = lv_display_get_horizontal_resolution(disp);
+  const uint16_t *src = (const uint16_t *)px_map + area->y1 * stride + area->x1;
+
+  for (int32_t y = area->y1; y <= area->y2; y += DIRECT_STAGE_LINES) {
+    uint32_t rows = min((int32_t)DIRECT_STAGE_LINES, area->y2 - y + 1);
+    for (uint32_t r = 0; r < rows; r++) {
+      memcpy(stageBuf + r * w, src + (y - area->y1 + r) * stride, w * 2);
+    }
+    flushBand(area->x1, y, w, rows, stageBuf);
+  }
+}
+
+static void flushTask(void *arg) {
+  (void)arg;
+  FlushJob job;
+  for (;;) {
+    if (xQueueReceive(flushQueue, &job, portMAX_DELAY) != pdTRUE) continue;
+    flushBand(job.area.x1, job.area.y1, lv_area_get_width(&job.area),
+              lv_area_get_height(&job.area), (uint16_t *)job.px_map);
+    flushPending = false;
+    lv_display_flush_ready(job.disp);
+    xSemaphoreGive(flushDone);
+  }
+}
+
+// LVGL calls this instead of spinning while a band is still on the bus
+static void flush_wait_cb(lv_display_t *disp) {
+  display_flush_wait();
+}
+
+void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
+  if (config.mode == DISPLAY_MODE_DIRECT) {
+    drawDirect(disp, area, px_map);
+  } else if (asyncFlush) {
+    FlushJob job = { disp, *area, px_map };
+    flushPending = true;
+    xQueueSend(flushQueue, &job, portMAX_DELAY);
+    return;
+  } else {
+    flushBand(area->x1, area->y1, lv_area_get_width(area), lv_area_get_height(area), (uint16_t *)px_map);
+  }
   lv_disp_flush_ready(disp);
 }
 
+// Pixel-equivalent cost of sending one area: a window per band plus its pixels.
+// A partial band of `bandPx` pixels holds as many rows of the area as fit its
+// width (LVGL's get_max_row), kept even for the rounder.
+static uint32_t areaCost(const lv_area_t *area, uint32_t bandPx) {
+  uint32_t rowsPerWindow = DIRECT_STAGE_LINES;
+  if (config.mode == DISPLAY_MODE_PARTIAL) {
+    rowsPerWindow = max<uint32_t>(2, (bandPx / lv_area_get_width(area)) & ~1u);
+  }
+  uint32_t windows = (lv_area_get_height(area) + rowsPerWindow - 1) / rowsPerWindow;
+  return windows * config.windowCost + lv_area_get_size(area);
+}
+
+// LVGL has already joined areas that touch when that saves pixels. Keep
+// merging the pair with the biggest saving under the window cost model.
+// The later slot always survives so LVGL's precomputed last area stays valid.
+static void coalesce_event_cb(lv_event_t *e) {
+  lv_display_t *disp = (lv_display_t *)lv_event_get_current_target(e);
+  uint32_t n = disp->inv_p;
+  uint32_t bandPx = lv_display_get_horizontal_resolution(disp) * config.lines;
+  uint8_t *joined = disp->inv_area_joined;
+
+  if (config.windowCost) {
+    for (;;) {
+      int32_t bestSaving = 0;
+      int32_t from = -1, into = -1;
+      lv_area_t bestArea;
+      for (uint32_t i = 0; i < n; i++) {
+        if (joined[i]) continue;
+        uint32_t costI = areaCost(&disp->inv_areas[i], bandPx);
+        for (uint32_t j = i + 1; j < n; j++) {
+          if (joined[j]) continue;
+          lv_area_t merged;
+          lv_area_set(&merged,
+                      LV_MIN(disp->inv_areas[i].x1, disp->inv_areas[j].x1),
+                      LV_MIN(disp->inv_areas[i].y1, disp->inv_areas[j].y1),
+                      LV_MAX(disp->inv_areas[i].x2, disp->inv_areas[j].x2),
+                      LV_MAX(disp->inv_areas[i].y2, disp->inv_areas[j].y2));
+          int32_t saving = (int32_t)(costI + areaCost(&disp->inv_areas[j], bandPx)) -
+                           (int32_t)areaCost(&merged, bandPx);
+          if (saving > bestSaving) {
+            bestSaving = saving;
+            from = i;
+            into = j;
+            bestArea = merged;
+          }
+        }
+      }
+      if (from < 0) break;
+      disp->inv_areas[into] = bestArea;
+      joined[from] = 1;
+      flushStats.merged++;
+    }
+  }
+
+  flushStats.frames++;
+  for (uint32_t i = 0; i < n; i++) {
+    if (!joined[i]) flushStats.areas++;
+  }
+}
+
 void rounder_event_cb(lv_event_t *e) {
   lv_area_t *area = (lv_area_t *)lv_event_get_param(e);
   area->x1 = (area->x1 >> 1) << 1;
@@ -28,15 +338,239 @@ void rounder_event_cb(lv_event_t *e) {
 }
 
 void display_init() {
+  busLock = xSemaphoreCreateMutex();
   if (!gfx->begin()) {
     USBSerial.println("gfx->begin() failed!");
   }
   gfx->fillScreen(RGB565_BLACK);
+  shadowFill(true);
 
   // Set default brightness to 20% for power saving
   display_set_brightness(51);  // 20% brightness as default
 }
 
+static bool parseConfigLine(display_config_t *cfg, char *line) {
+  char *hash = strchr(line, '#');
+  if (hash) *hash = '\0';
+  char key[16], value[16];
+  int n = sscanf(line, "%15s %15s", key, value);
+  if (n <= 0) return true;  // blank or comment
+  if (n != 2) return false;
+
+  if (strcmp(key, "mode") == 0) {
+    if (strcmp(value, "partial") == 0) cfg->mode = DISPLAY_MODE_PARTIAL;
+    else if (strcmp(value, "direct") == 0) cfg->mode = DISPLAY_MODE_DIRECT;
+    else return false;
+  } else if (strcmp(key, "lines") == 0) {
+    int lines = atoi(value);
+    if (lines < DRAW_BUF_LINES_MIN || lines > DRAW_BUF_LINES_MAX) return false;
+    cfg->lines = lines & ~1;  // whole rounder-aligned row pairs
+  } else if (strcmp(key, "buffers") == 0) {
+    int buffers = atoi(value);
+    if (buffers < 1 || buffers > 2) return false;
+    cfg->buffers = buffers;
+  } else if (strcmp(key, "window_cost") == 0) {
+    int cost = atoi(value);
+    if (cost < 0 || cost > UINT16_MAX) return false;
+    cfg->windowCost = cost;
+  } else if (strcmp(key, "black_skip") == 0) {
+    if (strcmp(value, "on") == 0) cfg->blackSkip = true;
+    else if (strcmp(value, "off") == 0) cfg->blackSkip = false;
+    else return false;
+  } else if (strcmp(key, "bench") == 0) {
+    if (strcmp(value, "off") == 0) cfg->bench = DISPLAY_BENCH_OFF;
+    else if (strcmp(value, "on") == 0) cfg->bench = DISPLAY_BENCH_ON;
+    else if (strcmp(value, "sweep") == 0) cfg->bench = DISPLAY_BENCH_SWEEP;
+    else return false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void display_load_config(display_config_t *cfg) {
+  *cfg = { DISPLAY_DEFAULT_MODE, DRAW_BUF_LINES, 2, DISPLAY_WINDOW_COST_PX, true, DISPLAY_BENCH_OFF };
+  if (!sd_card_is_mounted()) return;
+  File f = SD_MMC.open(DISPLAY_CFG_PATH, FILE_READ);
+  if (!f) return;
+
+  char line[64];
+  int lineNo = 0;
+  while (f.available()) {
+    size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    lineNo++;
+    if (!parseConfigLine(cfg, line)) {
+      USBSerial.printf("[DISP] %s:%d ignored: %s\n", DISPLAY_CFG_PATH, lineNo, line);
+    }
+  }
+  f.close();
+}
+
+static void freeBuffers() {
+  for (int i = 0; i < 2; i++) {
+    heap_caps_free(drawBuf[i]);
+    drawBuf[i] = nullptr;
+  }
+  heap_caps_free(stageBuf);
+  stageBuf = nullptr;
+}
+
+static void startFlushTask() {
+  if (flushQueue) return;
+  flushQueue = xQueueCreate(1, sizeof(FlushJob));
+  flushDone = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(flushTask, "disp_flush", FLUSH_TASK_STACK, nullptr,
+                          FLUSH_TASK_PRIORITY, nullptr, FLUSH_TASK_CORE);
+}
+
+static bool configureDirect(lv_display_t *disp, uint32_t width, uint32_t height) {
+  uint32_t size = width * height * 2;
+  drawBuf[0] = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  stageBuf = (uint16_t *)heap_caps_malloc(width * DIRECT_STAGE_LINES * 2, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  if (!drawBuf[0] || !stageBuf) {
+    freeBuffers();
+    return false;
+  }
+  asyncFlush = false;
+  lv_display_set_flush_wait_cb(disp, NULL);
+  lv_display_set_buffers(disp, drawBuf[0], NULL, size, LV_DISPLAY_RENDER_MODE_DIRECT);
+  return true;
+}
+
+static bool configurePartial(lv_display_t *disp, uint32_t width, display_config_t *cfg) {
+  uint32_t size = width * cfg->lines * 2;
+  drawBuf[0] = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  if (!drawBuf[0]) {
+    drawBuf[0] = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  }
+  if (!drawBuf[0]) return false;
+
+  // Second band so LVGL can render while the first is on the QSPI bus;
+  // without it we just fall back to single-buffered
+  if (cfg->buffers > 1) {
+    drawBuf[1] = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!drawBuf[1]) {
+      USBSerial.println("[DISP] Second draw buffer allocate failed, single buffer");
+      cfg->buffers = 1;
+    }
+  }
+
+#ifdef DISPLAY_SYNC_FLUSH
+  asyncFlush = false;
+#else
+  asyncFlush = drawBuf[1] != nullptr;
+#endif
+  if (asyncFlush) startFlushTask();
+  lv_display_set_flush_wait_cb(disp, asyncFlush ? flush_wait_cb : NULL);
+  lv_display_set_buffers(disp, drawBuf[0], drawBuf[1], size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+  return true;
+}
+
+bool display_configure(lv_display_t *disp, const display_config_t *cfg) {
+  uint32_t width = lv_display_get_horizontal_resolution(disp);
+  uint32_t height = lv_display_get_vertical_resolution(disp);
+  display_config_t want = *cfg;
+
+  // LVGL must not touch the old buffers between here and set_buffers
+  display_flush_wait();
+  freeBuffers();
+
+  bool ok = false;
+  if (want.mode == DISPLAY_MODE_DIRECT) {
+    want.buffers = 1;
+    ok = configureDirect(disp, width, height);
+    if (!ok) {
+      USBSerial.println("[DISP] No PSRAM for a direct framebuffer, using partial");
+      want.mode = DISPLAY_MODE_PARTIAL;
+      want.buffers = 2;
+      if (want.lines < DRAW_BUF_LINES_MIN) want.lines = DRAW_BUF_LINES;
+    }
+  }
+  if (!ok) ok = configurePartial(disp, width, &want);
+  if (!ok) return false;
+
+  config = want;
+  char desc[48];
+  display_format_config(&config, desc, sizeof(desc));
+  USBSerial.printf("[DISP] Render %s\n", desc);
+  lv_obj_invalidate(lv_screen_active());
+  return true;
+}
+
+lv_display_t *display_create(uint32_t width, uint32_t height, const display_config_t *cfg) {
+  lv_display_t *disp = lv_display_create(width, height);
+  lv_display_set_flush_cb(disp, my_disp_flush);
+  if (!display_configure(disp, cfg)) {
+    lv_display_delete(disp);
+    return nullptr;
+  }
+  lv_display_add_event_cb(disp, rounder_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+  lv_display_add_event_cb(disp, coalesce_event_cb, LV_EVENT_RENDER_START, NULL);
+  return disp;
+}
+
+const display_config_t *display_get_config() {
+  return &config;
+}
+
+void display_format_config(const display_config_t *cfg, char *buf, size_t size) {
+  char mode[24];
+  if (cfg->mode == DISPLAY_MODE_DIRECT) {
+    snprintf(mode, sizeof(mode), "direct");
+  } else {
+    snprintf(mode, sizeof(mode), "partial %ux%u", cfg->lines, cfg->buffers);
+  }
+  if (cfg->windowCost) {
+    snprintf(buf, size, "%s, window cost %u px%s", mode, cfg->windowCost,
+             cfg->blackSkip ? ", black skip" : "");
+  } else {
+    snprintf(buf, size, "%s, no coalescing%s", mode, cfg->blackSkip ? ", black skip" : "");
+  }
+}
+
+void display_flush_wait() {
+  // A stale give only costs one extra pass through the loop
+  while (flushPending) {
+    xSemaphoreTake(flushDone, pdMS_TO_TICKS(10));
+  }
+}
+
+uint32_t display_measure_full_redraw() {
+  lv_obj_invalidate(lv_screen_active());
+  int64_t start = esp_timer_get_time();
+  lv_refr_now(NULL);
+  display_flush_wait();
+  uint32_t us = esp_timer_get_time() - start;
+  USBSerial.printf("[DISP] Full redraw: %lu.%02lu ms (%s flush)\n", us / 1000, us % 1000 / 10,
+                   asyncFlush ? "async" : "sync");
+  return us;
+}
+
+void display_get_flush_stats(display_flush_stats_t *stats) {
+  *stats = flushStats;
+}
+
+void display_format_flush_stats(char *buf, size_t size) {
+  const display_flush_stats_t &s = flushStats;
+  uint32_t frames = s.frames ? s.frames : 1;
+  snprintf(buf, size,
+           "[DISP] %lu frames, %lu areas (%lu merged), %lu windows, %llu px, %llu black px skipped\n"
+           "[DISP] per frame: %lu.%02lu windows, %lu px, %lu us on the bus\n",
+           s.frames, s.areas, s.merged, s.flushes, s.bytes / 2, s.skippedBytes / 2,
+           s.flushes / frames, s.flushes % frames * 100 / frames,
+           (uint32_t)(s.bytes / 2 / frames), (uint32_t)(s.busyUs / frames));
+}
+
+void display_set_power(bool on) {
+  if (!gfx) return;
+  display_flush_wait();
+  if (busLock) xSemaphoreTake(busLock, portMAX_DELAY);
+  if (on) gfx->displayOn();
+  else gfx->displayOff();
+  if (busLock) xSemaphoreGive(busLock);
+}
+
 void display_set_brightness(uint8_t brightness) {
   // Safety check - ensure gfx is valid
   if (!gfx) {
@@ -45,5 +579,7 @@ void display_set_brightness(uint8_t brightness) {
 
   // Cast to CO5300 to access brightness control
   Arduino_CO5300 *co5300 = static_cast<Arduino_CO5300*>(gfx);
+  if (busLock) xSemaphoreTake(busLock, portMAX_DELAY);
   co5300->setBrightness(brightness);
+  if (busLock) xSemaphoreGive(busLock);
 }
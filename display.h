@@ -7,7 +7,65 @@
 extern Arduino_DataBus *bus;
 extern Arduino_GFX *gfx;
 
+// Boot-time render settings, read from DISPLAY_CFG_PATH on the SD card:
+//   mode partial|direct   lines <band height>   buffers 1|2
+//   window_cost <px>      black_skip on|off   bench off|on|sweep
+#define DISPLAY_CFG_PATH "/display.cfg"
+
+// Default lines per LVGL draw buffer; two buffers are used so one renders
+// while the other is on the QSPI bus
+#define DRAW_BUF_LINES 40
+#define DRAW_BUF_LINES_MIN 8
+#define DRAW_BUF_LINES_MAX 160
+
+// Cost of one extra flush window (CASET/RASET/RAMWR plus LVGL's per-area
+// setup) in pixel equivalents. Dirty areas are merged while one window over
+// their bounding box is cheaper than separate windows; 0 leaves it to LVGL.
+#define DISPLAY_WINDOW_COST_PX 600
+
+enum display_render_mode_t : uint8_t {
+  DISPLAY_MODE_PARTIAL,  // bands of `lines` rows in internal RAM
+  DISPLAY_MODE_DIRECT,   // full framebuffer in PSRAM, only dirty areas are sent
+};
+
+enum display_bench_mode_t : uint8_t {
+  DISPLAY_BENCH_OFF,
+  DISPLAY_BENCH_ON,      // run the frame benchmark once at boot
+  DISPLAY_BENCH_SWEEP,   // ...for every candidate configuration
+};
+
+struct display_config_t {
+  display_render_mode_t mode;
+  uint16_t lines;
+  uint8_t buffers;
+  uint16_t windowCost;
+  bool blackSkip;       // leave out rows/columns that are black and already black on the panel
+  display_bench_mode_t bench;
+};
+
+struct display_flush_stats_t {
+  uint32_t flushes;   // draw16bitRGBBitmap() calls
+  uint64_t bytes;     // pixel bytes pushed to the panel
+  uint64_t busyUs;    // time spent pushing them
+  uint32_t frames;    // refreshes that rendered something
+  uint32_t areas;     // dirty areas rendered, after coalescing
+  uint32_t merged;    // areas folded into a neighbour by the cost model
+  uint64_t skippedBytes;  // black pixel bytes the panel already showed
+};
+
 void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map);
 void rounder_event_cb(lv_event_t *e);
 void display_init();
+void display_load_config(display_config_t *cfg);  // Defaults, overridden by DISPLAY_CFG_PATH
+// Create the LVGL display with buffers for cfg; nullptr if nothing could be allocated
+lv_display_t *display_create(uint32_t width, uint32_t height, const display_config_t *cfg);
+// Swap buffers/render mode at runtime; falls back to fewer buffers or partial mode
+bool display_configure(lv_display_t *disp, const display_config_t *cfg);
+const display_config_t *display_get_config();  // What was actually allocated
+void display_format_config(const display_config_t *cfg, char *buf, size_t size);
+void display_flush_wait();  // Block until the last band has reached the panel
+uint32_t display_measure_full_redraw();  // Redraw the active screen now; returns and logs microseconds
+void display_get_flush_stats(display_flush_stats_t *stats);
+void display_format_flush_stats(char *buf, size_t size);  // totals and per-frame averages
+void display_set_power(bool on);  // Panel on/off, safe against an in-flight flush
 void display_set_brightness(uint8_t brightness);  // Brightness control wrapper
@@ -0,0 +1,177 @@
+#include "display_bench.h"
+#include "HWCDC.h"
+#include "notification_ui.h"
+#include "rtc_clock.h"
+#include <esp_timer.h>
+#include "ui/WizWatch/src/ui/screens.h"
+
+extern HWCDC USBSerial;
+
+#define BENCH_FULL_FRAMES    5
+#define BENCH_LABEL_FRAMES   20
+#define BENCH_SLIDE_MS       300   // NOTIF_ANIM_MS
+#define BENCH_SLIDER_STEP    5
+#define BENCH_SETTLE_MS      400   // let the dismiss animation finish off the clock
+
+struct BenchStep {
+  uint32_t frames;
+  uint64_t us;
+  uint64_t bytes;
+  uint32_t flushes;
+  uint32_t areas;
+};
+
+static display_flush_stats_t stepStart;
+
+static void beginStep(BenchStep *step) {
+  memset(step, 0, sizeof(*step));
+  display_get_flush_stats(&stepStart);
+}
+
+// One frame: render everything invalid and wait until it is on the panel
+static void frame(BenchStep *step) {
+  int64_t start = esp_timer_get_time();
+  lv_refr_now(NULL);
+  display_flush_wait();
+  step->us += esp_timer_get_time() - start;
+  step->frames++;
+}
+
+static void endStep(BenchStep *step, const char *name) {
+  display_flush_stats_t end;
+  display_get_flush_stats(&end);
+  step->bytes = end.bytes - stepStart.bytes;
+  step->flushes = end.flushes - stepStart.flushes;
+  step->areas = end.areas - stepStart.areas;
+
+  uint32_t frames = step->frames ? step->frames : 1;
+  uint32_t usPerFrame = step->us / frames;
+  USBSerial.printf("[BENCH]   %-12s %3lu frames %4lu.%02lu ms/frame %7lu B/frame %6lu px/frame "
+                   "%3lu areas/frame %4lu windows/frame\n",
+                   name, step->frames, usPerFrame / 1000, usPerFrame % 1000 / 10,
+                   (uint32_t)(step->bytes / frames), (uint32_t)(step->bytes / 2 / frames),
+                   step->areas / frames, step->flushes / frames);
+}
+
+// Let animations and screen loads run without counting them
+static void settle(uint32_t ms) {
+  uint32_t start = millis();
+  while (millis() - start < ms) {
+    lv_timer_handler();
+    delay(1);
+  }
+  display_flush_wait();
+}
+
+// Repeated full-screen redraws of whatever is showing: the first frame pays
+// for everything, the rest show what the flush path can leave out
+static void fullRedraws(const char *name) {
+  BenchStep step;
+  beginStep(&step);
+  for (int i = 0; i < BENCH_FULL_FRAMES; i++) {
+    lv_obj_invalidate(lv_screen_active());
+    frame(&step);
+  }
+  endStep(&step, name);
+}
+
+static void runScript(lv_obj_t *home) {
+  BenchStep step;
+
+  lv_screen_load(objects.main);
+  settle(0);
+
+  fullRedraws("full");
+
+  beginStep(&step);
+  for (int i = 0; i < BENCH_LABEL_FRAMES; i++) {
+    lv_label_set_text_fmt(objects.time_lbl, "%02d:%02d", 10 + i % 2, i);
+    frame(&step);
+  }
+  endStep(&step, "time label");
+  rtc_update_display();
+
+  // Animations advance with real time, so the frame count here is whatever
+  // fits in the slide duration at the achieved frame rate
+  notification_ui_show("Bench", "Benchmark", "Notification slide-in");
+  beginStep(&step);
+  uint32_t start = millis();
+  while (millis() - start < BENCH_SLIDE_MS) {
+    lv_anim_refr_now();
+    frame(&step);
+  }
+  endStep(&step, "notification");
+  settle(BENCH_SETTLE_MS);
+  fullRedraws("card full");
+  notification_ui_dismiss();
+  settle(BENCH_SETTLE_MS);
+
+  lv_screen_load(objects.settings);
+  settle(0);
+  fullRedraws("settings");
+  int32_t saved = lv_slider_get_value(objects.brightnessslider);
+  int32_t lo = lv_slider_get_min_value(objects.brightnessslider);
+  int32_t hi = lv_slider_get_max_value(objects.brightnessslider);
+  beginStep(&step);
+  for (int32_t v = lo; v <= hi; v += BENCH_SLIDER_STEP) {
+    lv_slider_set_value(objects.brightnessslider, v, LV_ANIM_OFF);
+    frame(&step);
+  }
+  endStep(&step, "slider drag");
+  lv_slider_set_value(objects.brightnessslider, saved, LV_ANIM_OFF);
+
+  lv_screen_load(home);
+  settle(0);
+}
+
+static void benchConfig(lv_display_t *disp, lv_obj_t *home, const display_config_t *cfg) {
+  if (!display_configure(disp, cfg)) return;
+  char desc[48];
+  display_format_config(display_get_config(), desc, sizeof(desc));
+  USBSerial.printf("[BENCH] %s\n", desc);
+  runScript(home);
+}
+
+void display_bench_run(lv_display_t *disp, display_bench_mode_t mode) {
+  if (!disp || mode == DISPLAY_BENCH_OFF) return;
+  lv_obj_t *home = lv_screen_active();
+  display_config_t configured = *display_get_config();
+
+  if (mode == DISPLAY_BENCH_ON) {
+    benchConfig(disp, home, &configured);
+    return;
+  }
+
+  struct Candidate {
+    display_render_mode_t mode;
+    uint16_t lines;
+    uint8_t buffers;
+  };
+  static const Candidate candidates[] = {
+    { DISPLAY_MODE_PARTIAL, 20, 1 },
+    { DISPLAY_MODE_PARTIAL, 20, 2 },
+    { DISPLAY_MODE_PARTIAL, 40, 1 },
+    { DISPLAY_MODE_PARTIAL, 40, 2 },
+    { DISPLAY_MODE_PARTIAL, 80, 1 },
+    { DISPLAY_MODE_PARTIAL, 80, 2 },
+    { DISPLAY_MODE_DIRECT,  DRAW_BUF_LINES, 1 },
+  };
+  for (const Candidate &c : candidates) {
+    display_config_t cfg = configured;
+    cfg.mode = c.mode;
+    cfg.lines = c.lines;
+    cfg.buffers = c.buffers;
+    benchConfig(disp, home, &cfg);
+  }
+
+  // The configured setting once more without each flush optimisation
+  display_config_t plain = configured;
+  plain.windowCost = 0;
+  benchConfig(disp, home, &plain);
+  plain = configured;
+  plain.blackSkip = false;
+  benchConfig(disp, home, &plain);
+
+  USBSerial.println("[BENCH] Restoring configured render mode");
+  display_configure(disp, &configured);
+}
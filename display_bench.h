@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+
+// Frame benchmark: renders a fixed script (full redraw, time label change,
+// notification slide-in, full redraw under the notification card, settings
+// full redraw, brightness slider drag) as fast as the panel allows and logs
+// ms/frame and QSPI bytes/frame for each step.
+// DISPLAY_BENCH_SWEEP repeats it for every candidate render configuration,
+// then restores the configured one.
+void display_bench_run(lv_display_t *disp, display_bench_mode_t mode);
@@ -0,0 +1,837 @@
+#include "gb_protocol.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ---- Line framing ----
+
+void gb_framer_reset(gb_framer_t *f) {
+    f->len = 0;
+    f->overflow = false;
+}
+
+static bool isTrimmable(char c) {
+    // Whitespace plus any control character (Espruino sends a \x10 prefix)
+    return (uint8_t)c <= 0x20;
+}
+
+static bool startsWith(const char *s, size_t len, const char *prefix) {
+    size_t n = strlen(prefix);
+    return len >= n && memcmp(s, prefix, n) == 0;
+}
+
+// Trim the completed line in place and classify it
+static bool finishLine(gb_framer_t *f, gb_line_t *line) {
+    char *s = f->buf;
+    size_t len = f->len;
+    f->len = 0;
+
+    while (len > 0 && isTrimmable(*s)) { s++; len--; }
+    while (len > 0 && isTrimmable(s[len - 1])) len--;
+    if (len == 0) return false;
+    s[len] = '\0';
+
+    f->lines++;
+    line->kind = GB_LINE_OTHER;
+    if (startsWith(s, len, "GB(") && s[len - 1] == ')') {
+        s[len - 1] = '\0';
+        line->kind = GB_LINE_GB;
+        s += 3;
+        len -= 4;
+    } else if (startsWith(s, len, "setTime(")) {
+        line->kind = GB_LINE_SETTIME;
+    }
+    line->data = s;
+    line->len = len;
+    return true;
+}
+
+size_t gb_framer_feed(gb_framer_t *f, const char *data, size_t len, gb_line_t *line) {
+    line->data = nullptr;
+    line->len = 0;
+
+    const char *nl = (const char *)memchr(data, '\n', len);
+    size_t chunk = nl ? (size_t)(nl - data) : len;
+
+    if (!f->overflow) {
+        if (f->len + chunk > GB_LINE_MAX) {
+            f->overflow = true;
+            f->overflows++;
+            f->len = 0;
+        } else {
+            memcpy(&f->buf[f->len], data, chunk);
+            f->len += chunk;
+        }
+    }
+
+    if (!nl) return len;
+
+    if (f->overflow) {
+        f->overflow = false;
+        f->len = 0;
+    } else {
+        finishLine(f, line);
+    }
+    return chunk + 1;
+}
+
+// ---- atob() / \xNN decoding ----
+
+// Bounded output cursor; `ok` latches false on overflow
+struct JsonWriter {
+    char *out;
+    size_t size;
+    size_t len;
+    bool ok;
+
+    void put(char c) {
+        if (len + 1 < size) out[len++] = c;
+        else ok = false;
+    }
+};
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Emit one Latin-1 character as JSON string content in UTF-8
+static void putLatin1(JsonWriter &w, uint8_t c) {
+    if (c < 0x20) {
+        w.put('\\'); w.put('u'); w.put('0'); w.put('0');
+        w.put(HEX_DIGITS[c >> 4]); w.put(HEX_DIGITS[c & 0x0F]);
+    } else if (c == '"' || c == '\\') {
+        w.put('\\'); w.put((char)c);
+    } else if (c < 0x80) {
+        w.put((char)c);
+    } else {
+        w.put((char)(0xC0 | (c >> 6)));
+        w.put((char)(0x80 | (c & 0x3F)));
+    }
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;   // standard and URL-safe alphabets
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+// UTF-8 "…" marks text cut at the display limit
+static const char ELLIPSIS[] = "\xE2\x80\xA6";
+#define ELLIPSIS_LEN 3
+
+// Decode base64 text [in, in+len) straight into the writer as a JSON string body,
+// stopping at `limit` UTF-8 bytes of text (0 = no limit). Decoded control
+// characters are dropped, like the old decodeAtob(); characters outside the
+// alphabet (line breaks, stray bytes) are skipped instead of failing the string.
+static void putBase64(JsonWriter &w, const char *in, size_t len, size_t limit) {
+    uint32_t acc = 0;
+    int bits = 0;
+    size_t shown = 0;           // UTF-8 bytes of text written
+    size_t fitMark = w.len;     // last position that still leaves room for the ellipsis
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == '=') break;
+        int v = base64Value(in[i]);
+        if (v < 0) continue;
+        acc = (acc << 6) | (uint32_t)v;
+        bits += 6;
+        if (bits < 8) continue;
+
+        bits -= 8;
+        uint8_t c = (uint8_t)(acc >> bits);
+        if (c < 0x20) continue;
+
+        size_t n = c < 0x80 ? 1 : 2;
+        if (limit && shown + n > limit) {
+            // Back up to a whole character that leaves room for the marker
+            w.len = fitMark;
+            for (int k = 0; k < ELLIPSIS_LEN; k++) w.put(ELLIPSIS[k]);
+            return;
+        }
+        putLatin1(w, c);
+        shown += n;
+        if (shown + ELLIPSIS_LEN <= limit) fitMark = w.len;
+    }
+}
+
+// atob() text lands in these event fields; each is cut to what its field holds
+struct TextField {
+    const char *key;
+    size_t limit;
+};
+static const TextField textFields[] = {
+    { "src",    BT_SRC_MAX - 1 },
+    { "sender", BT_SENDER_MAX - 1 },
+    { "title",  BT_TITLE_MAX - 1 },
+    { "body",   BT_BODY_MAX - 1 },
+    { "artist", BT_ARTIST_MAX - 1 },
+    { "track",  BT_TRACK_MAX - 1 },
+    { "txt",    BT_WEATHER_MAX - 1 },
+    { "cmd",    BT_CALL_CMD_MAX - 1 },
+    { "name",   BT_CALL_NAME_MAX - 1 },
+};
+
+// Limit for the value of key [key, key+len); `fallback` for keys without a field
+static size_t fieldLimit(const char *key, size_t len, size_t fallback) {
+    for (const TextField &f : textFields) {
+        if (strlen(f.key) == len && memcmp(f.key, key, len) == 0) {
+            return f.limit < fallback ? f.limit : fallback;
+        }
+    }
+    return fallback;
+}
+
+// Whether the atob( at in[i] is the value of the string that closed at keyEnd:
+// only whitespace and one ':' lie between them
+static bool isValueOf(const char *in, size_t i, size_t keyEnd) {
+    bool colon = false;
+    while (i > keyEnd + 1) {
+        char c = in[--i];
+        if (c == ':' && !colon) colon = true;
+        else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return false;
+    }
+    return colon;
+}
+
+int gb_decode_json(const char *in, size_t len, char *out, size_t outSize, size_t textLimit) {
+    JsonWriter w = { out, outSize, 0, true };
+    bool inString = false;
+    size_t i = 0;
+    size_t strStart = 0;                 // first character of the current / last string
+    size_t keyStart = 0, keyEnd = SIZE_MAX;   // last string seen, keyEnd at its closing quote
+
+    while (i < len && w.ok) {
+        char c = in[i];
+
+        if (!inString) {
+            // atob("...") — Gadgetbridge base64-encodes non-ASCII text
+            if (c == 'a' && len - i > 6 && memcmp(&in[i], "atob(\"", 6) == 0) {
+                const char *start = &in[i + 6];
+                const char *end = (const char *)memchr(start, '"', len - i - 6);
+                if (end && (size_t)(end - in) + 1 < len && end[1] == ')') {
+                    size_t limit = textLimit;
+                    if (textLimit && keyEnd != SIZE_MAX && isValueOf(in, i, keyEnd)) {
+                        limit = fieldLimit(&in[keyStart], keyEnd - keyStart, textLimit);
+                    }
+                    w.put('"');
+                    putBase64(w, start, end - start, limit);
+                    w.put('"');
+                    i = (end - in) + 2;
+                    continue;
+                }
+            }
+            if (c == '"') {
+                inString = true;
+                strStart = i + 1;
+            }
+            w.put(c);
+            i++;
+            continue;
+        }
+
+        if (c == '"') {
+            inString = false;
+            keyStart = strStart;
+            keyEnd = i;
+        } else if (c == '\\' && i + 1 < len) {
+            // \xNN — a Latin-1 character
+            if (in[i + 1] == 'x' && i + 3 < len) {
+                int hi = hexValue(in[i + 2]);
+                int lo = hexValue(in[i + 3]);
+                if (hi >= 0 && lo >= 0) {
+                    putLatin1(w, (uint8_t)((hi << 4) | lo));
+                    i += 4;
+                    continue;
+                }
+            }
+            // Any other escape is valid JSON; copy both characters
+            w.put(c);
+            w.put(in[i + 1]);
+            i += 2;
+            continue;
+        }
+        w.put(c);
+        i++;
+    }
+
+    if (!w.ok) return -1;
+    out[w.len] = '\0';
+    return (int)w.len;
+}
+
+// ---- setTime(...) ----
+
+bool gb_parse_settime(const gb_line_t *line, long *ts, float *tzHours) {
+    if (line->kind != GB_LINE_SETTIME) return false;
+
+    char *end;
+    long t = strtol(line->data + 8, &end, 10);
+    if (end == line->data + 8 || *end != ')') return false;
+
+    // Timezone offset (hours) from E.setTimeZone(X.X), if present
+    float tz = 0;
+    const char *tzStart = strstr(end, "setTimeZone(");
+    if (tzStart) {
+        tz = strtof(tzStart + 12, &end);
+        if (*end != ')') tz = 0;
+    }
+
+    *ts = t;
+    *tzHours = tz;
+    return true;
+}
+
+// ---- JSON decoding ----
+
+// Every block carries its size so reallocate() can copy it; 8 bytes keeps
+// the payload 8-byte aligned for 64-bit values
+struct ArenaHeader {
+    uint32_t size;
+    uint32_t reserved;
+};
+
+static size_t alignUp(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+void *GbArena::allocate(size_t size) {
+    size_t need = sizeof(ArenaHeader) + alignUp(size);
+    if (_top + need > _size) {
+        _heapAllocs++;
+        return malloc(size);
+    }
+
+    ArenaHeader *h = (ArenaHeader *)&_buf[_top];
+    h->size = size;
+    _last = (uint8_t *)(h + 1);
+    _top += need;
+    if (_top > _peak) _peak = _top;
+    return _last;
+}
+
+void GbArena::deallocate(void *ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    // Only the most recent block can be given back; the rest goes with reset()
+    if (ptr == _last) {
+        _top = (uint8_t *)ptr - sizeof(ArenaHeader) - _buf;
+        _last = nullptr;
+    }
+}
+
+void *GbArena::reallocate(void *ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+    if (!owns(ptr)) {
+        _heapAllocs++;
+        return realloc(ptr, newSize);
+    }
+
+    ArenaHeader *h = (ArenaHeader *)ptr - 1;
+
+    // Grow or shrink the top block in place
+    if (ptr == _last) {
+        size_t base = (uint8_t *)ptr - _buf;
+        if (base + alignUp(newSize) <= _size) {
+            h->size = newSize;
+            _top = base + alignUp(newSize);
+            if (_top > _peak) _peak = _top;
+            return ptr;
+        }
+    } else if (newSize <= h->size) {
+        h->size = newSize;
+        return ptr;
+    }
+
+    size_t oldSize = h->size;
+    void *p = allocate(newSize);
+    if (p) memcpy(p, ptr, oldSize < newSize ? oldSize : newSize);
+    deallocate(ptr);
+    return p;
+}
+
+// ---- Binary channel ----
+
+void gb_bin_framer_reset(gb_bin_framer_t *f) {
+    f->len = 0;
+    f->need = 0;
+    f->headerLen = 0;
+}
+
+size_t gb_bin_framer_feed(gb_bin_framer_t *f, const uint8_t *data, size_t len,
+                          const uint8_t **frame, size_t *frameLen) {
+    *frame = nullptr;
+    size_t off = 0;
+    while (off < len) {
+        if (f->headerLen < 2) {
+            f->header[f->headerLen++] = data[off++];
+            if (f->headerLen == 2) {
+                f->need = f->header[0] | (f->header[1] << 8);
+                f->len = 0;
+                if (f->need > GB_BIN_FRAME_MAX) f->overflows++;
+                if (f->need == 0) f->headerLen = 0;
+            }
+            continue;
+        }
+
+        // Oversized frames are consumed but not stored
+        size_t n = len - off < f->need - f->len ? len - off : f->need - f->len;
+        if (f->need <= GB_BIN_FRAME_MAX) memcpy(&f->buf[f->len], &data[off], n);
+        f->len += n;
+        off += n;
+
+        if (f->len == f->need) {
+            f->headerLen = 0;
+            if (f->need <= GB_BIN_FRAME_MAX) {
+                f->frames++;
+                *frame = f->buf;
+                *frameLen = f->len;
+                return off;
+            }
+        }
+    }
+    return off;
+}
+
+// Length of a MessagePack str at `p`, or -1 if it isn't one; `header` gets its size
+static int msgpackStrLen(const uint8_t *p, const uint8_t *end, size_t *header) {
+    if (p >= end) return -1;
+    if ((*p & 0xe0) == 0xa0) { *header = 1; return *p & 0x1f; }           // fixstr
+    if (*p == 0xd9 && end - p >= 2) { *header = 2; return p[1]; }          // str 8
+    return -1;
+}
+
+bool gb_peek_type_msgpack(const uint8_t *data, size_t len, char *type, size_t size) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    // Map header: fixmap, map 16 or map 32
+    if (p >= end) return false;
+    if ((*p & 0xf0) == 0x80) p += 1;
+    else if (*p == 0xde) p += 3;
+    else if (*p == 0xdf) p += 5;
+    else return false;
+
+    size_t header;
+    int n = msgpackStrLen(p, end, &header);
+    if (n != 1 || p + header + 1 > end || p[header] != 't') return false;
+    p += header + 1;
+
+    n = msgpackStrLen(p, end, &header);
+    if (n < 0 || p + header + n > end || (size_t)n >= size) return false;
+    memcpy(type, p + header, n);
+    type[n] = '\0';
+    return true;
+}
+
+static const char *skipSpace(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+// Past the closing quote of the string starting at p, nullptr if unterminated
+static const char *skipString(const char *p) {
+    for (p++; *p; p++) {
+        if (*p == '\\') {
+            if (!*++p) return nullptr;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return nullptr;
+}
+
+// Past one value (string, nested object/array or scalar), nullptr if malformed
+static const char *skipValue(const char *p) {
+    if (*p == '"') return skipString(p);
+    int depth = 0;
+    for (; *p; p++) {
+        if (*p == '"') {
+            p = skipString(p);
+            if (!p) return nullptr;
+            p--;
+        } else if (*p == '{' || *p == '[') {
+            depth++;
+        } else if (*p == '}' || *p == ']') {
+            if (depth == 0) return p;
+            if (--depth == 0) return p + 1;
+        } else if (*p == ',' && depth == 0) {
+            return p;
+        }
+    }
+    return depth == 0 ? p : nullptr;
+}
+
+bool gb_peek_type(const char *json, char *type, size_t size) {
+    // Walk the top-level members only, so a nested "t" is never taken
+    const char *p = skipSpace(json);
+    if (*p++ != '{') return false;
+    for (;;) {
+        p = skipSpace(p);
+        if (*p != '"') return false;
+        const char *key = p + 1;
+        p = skipString(p);
+        if (!p) return false;
+        bool isType = p - key == 2 && key[0] == 't';
+        p = skipSpace(p);
+        if (*p++ != ':') return false;
+        p = skipSpace(p);
+
+        if (isType) {
+            if (*p != '"') return false;
+            const char *start = p + 1;
+            const char *end = strchr(start, '"');
+            if (!end || (size_t)(end - start) >= size) return false;
+            memcpy(type, start, end - start);
+            type[end - start] = '\0';
+            return true;
+        }
+
+        p = skipValue(p);
+        if (!p) return false;
+        p = skipSpace(p);
+        if (*p++ != ',') return false;
+    }
+}
+
+void gb_build_filter(JsonDocument &filter, const char *const *keys) {
+    filter.clear();
+    filter["t"] = true;
+    for (; keys && *keys; keys++) {
+        filter[*keys] = true;
+    }
+}
+
+// ---- Message type dispatch ----
+
+static gb_type_t gbTypes[GB_TYPE_SLOTS];
+static size_t gbTypeCount = 0;
+static uint32_t gbTypeSeed = GB_FNV_BASIS;
+
+void gb_init_types(uint32_t seed) {
+    for (gb_type_t &t : gbTypes) {
+        t.def = nullptr;
+        t.filter.clear();
+        t.received = 0;
+    }
+    gbTypeCount = 0;
+    gbTypeSeed = seed;
+}
+
+bool gb_register_type(const gb_type_def_t *def) {
+    // Longer names could never be peeked out of a message
+    size_t nameLen = strnlen(def->type, GB_TYPE_NAME_MAX);
+    if (nameLen == 0 || nameLen >= GB_TYPE_NAME_MAX) return false;
+    // Keep the load factor at or below 3/4 so probes stay short
+    if (gbTypeCount >= GB_TYPE_SLOTS * 3 / 4) return false;
+
+    uint32_t slot = gb_type_hash(def->type, gbTypeSeed);
+    for (;; slot++) {
+        gb_type_t &t = gbTypes[slot & (GB_TYPE_SLOTS - 1)];
+        if (!t.def) {
+            t.def = def;
+            gb_build_filter(t.filter, def->keys);
+            gbTypeCount++;
+            return true;
+        }
+        if (strcmp(t.def->type, def->type) == 0) return false;
+    }
+}
+
+const gb_type_t *gb_find_type(const char *type) {
+    uint32_t slot = gb_type_hash(type, gbTypeSeed);
+    for (size_t probes = 0; probes < GB_TYPE_SLOTS; probes++, slot++) {
+        const gb_type_t &t = gbTypes[slot & (GB_TYPE_SLOTS - 1)];
+        if (!t.def) return nullptr;
+        if (strcmp(t.def->type, type) == 0) return &t;
+    }
+    return nullptr;
+}
+
+const gb_type_t *gb_type_at(size_t slot) {
+    if (slot >= GB_TYPE_SLOTS || !gbTypes[slot].def) return nullptr;
+    return &gbTypes[slot];
+}
+
+size_t gb_copy_utf8(char *dst, size_t size, const char *src) {
+    if (size == 0) return 0;
+    size_t len = strlen(src);
+    if (len >= size) {
+        len = size - 1;
+        // Back off continuation bytes so the cut lands on a character boundary
+        while (len > 0 && ((uint8_t)src[len] & 0xC0) == 0x80) len--;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+    return len;
+}
+
+// ---- Built-in message types ----
+
+static void copyField(char *dst, size_t size, JsonVariantConst v, const char *def) {
+    const char *str = v.as<const char *>();
+    gb_copy_utf8(dst, size, str ? str : def);
+}
+
+static bool decodeNotify(JsonObjectConst msg, gb_event_t *evt) {
+    bt_notification_t &n = evt->notify;
+    evt->kind = GB_EVT_NOTIFY;
+    n.id = msg["id"] | 0;
+    copyField(n.src,    sizeof(n.src),    msg["src"], "Unknown");
+    copyField(n.sender, sizeof(n.sender), msg["sender"], "");
+    copyField(n.title,  sizeof(n.title),  msg["title"], "");
+    copyField(n.body,   sizeof(n.body),   msg["body"], "");
+    return true;
+}
+
+static bool decodeNotifyDismiss(JsonObjectConst msg, gb_event_t *evt) {
+    evt->kind = GB_EVT_NOTIFY_DISMISS;
+    evt->notify.id = msg["id"] | 0;
+    return true;
+}
+
+static bool decodeMusicInfo(JsonObjectConst msg, gb_event_t *evt) {
+    bt_music_t &m = evt->music;
+    evt->kind = GB_EVT_MUSIC_INFO;
+    copyField(m.artist, sizeof(m.artist), msg["artist"], "");
+    copyField(m.track,  sizeof(m.track),  msg["track"], "");
+    m.duration = msg["dur"] | 0;
+    m.position = msg["c"] | 0;
+    return true;
+}
+
+static bool decodeMusicState(JsonObjectConst msg, gb_event_t *evt) {
+    const char *state = msg["state"] | "pause";
+    evt->kind = GB_EVT_MUSIC_STATE;
+    evt->music.playing = (strcmp(state, "play") == 0);
+    return true;
+}
+
+static bool decodeSetTime(JsonObjectConst msg, gb_event_t *evt) {
+    long ts = msg["ts"] | 0;
+    if (ts <= 0) return false;
+    evt->kind = GB_EVT_SET_TIME;
+    evt->time.ts = ts;
+    evt->time.tzHours = 0;
+    evt->time.hasZone = false;
+    return true;
+}
+
+static bool decodeWeather(JsonObjectConst msg, gb_event_t *evt) {
+    bt_weather_t &w = evt->weather;
+    evt->kind = GB_EVT_WEATHER;
+    w.temp     = msg["temp"] | 0;
+    w.humidity = msg["hum"] | 0;
+    copyField(w.txt, sizeof(w.txt), msg["txt"], "");
+    w.code     = msg["code"] | 0;
+    w.valid    = true;
+    return true;
+}
+
+static bool decodeCall(JsonObjectConst msg, gb_event_t *evt) {
+    bt_call_t &c = evt->call;
+    evt->kind = GB_EVT_CALL;
+    copyField(c.cmd,  sizeof(c.cmd),  msg["cmd"], "");
+    copyField(c.name, sizeof(c.name), msg["name"], "");
+    c.active = (strcmp(c.cmd, "incoming") == 0 || strcmp(c.cmd, "start") == 0);
+    return true;
+}
+
+static bool decodeFind(JsonObjectConst msg, gb_event_t *evt) {
+    evt->kind = GB_EVT_FIND;
+    evt->find = msg["n"] | false;
+    return true;
+}
+
+static bool decodeGpsQuery(JsonObjectConst msg, gb_event_t *evt) {
+    (void)msg;
+    evt->kind = GB_EVT_GPS_QUERY;
+    return true;
+}
+
+// Built-in message types and the keys each one reads; everything else is
+// skipped by the parser. More types can be added with gb_register_type().
+static constexpr gb_type_def_t gbBuiltinTypes[] = {
+    { "notify",        { "id", "src", "sender", "title", "body", nullptr }, decodeNotify },
+    { "notify-",       { "id", nullptr },                                   decodeNotifyDismiss },
+    { "musicinfo",     { "artist", "track", "dur", "c", nullptr },          decodeMusicInfo },
+    { "musicstate",    { "state", nullptr },                                decodeMusicState },
+    { "setTime",       { "ts", nullptr },                                   decodeSetTime },
+    { "weather",       { "temp", "hum", "txt", "code", nullptr },           decodeWeather },
+    { "call",          { "cmd", "name", nullptr },                          decodeCall },
+    { "find",          { "n", nullptr },                                    decodeFind },
+    { "is_gps_active", { nullptr },                                         decodeGpsQuery },
+};
+
+static constexpr uint32_t gbBuiltinSeed =
+    gb_perfect_seed(gbBuiltinTypes, sizeof(gbBuiltinTypes) / sizeof(gbBuiltinTypes[0]));
+static_assert(gbBuiltinSeed != 0, "no collision-free hash seed for the built-in GB types");
+
+// ---- Protocol pipeline ----
+
+// Static arena behind every JsonDocument built for an incoming message
+#define GB_ARENA_SIZE 8192
+
+static gb_framer_t framer;
+static gb_bin_framer_t binFramer;
+static char jsonBuf[GB_JSON_MAX];
+alignas(8) static uint8_t arenaBuf[GB_ARENA_SIZE];
+static GbArena arena(arenaBuf, sizeof(arenaBuf));
+static gb_event_t event;
+static gb_event_sink_t eventSink = nullptr;
+static gb_log_t logFn = nullptr;
+static gb_protocol_stats_t stats;
+static size_t textLimit = GB_TEXT_LIMIT;
+
+#define GB_LOG(...) do { if (logFn) logFn(__VA_ARGS__); } while (0)
+
+static void emit(const gb_event_t *evt) {
+    stats.messages++;
+    if (eventSink) eventSink(evt);
+}
+
+void gb_protocol_init(gb_event_sink_t sink, gb_log_t log) {
+    eventSink = sink;
+    logFn = log;
+    gb_framer_reset(&framer);
+    gb_bin_framer_reset(&binFramer);
+    gb_init_types(gbBuiltinSeed);
+    for (const gb_type_def_t &def : gbBuiltinTypes) {
+        gb_register_type(&def);
+    }
+}
+
+void gb_protocol_reset() {
+    gb_framer_reset(&framer);
+    gb_bin_framer_reset(&binFramer);
+}
+
+// Parse a message of a known type with its filter, run its decoder and emit the event
+static void decodeMessage(const gb_type_t *t, const void *data, size_t len, bool msgpack) {
+    GB_LOG("[GB] Message type: %s%s\n", t->def->type, msgpack ? " (binary)" : "");
+
+    uint32_t heapBefore = arena.heapAllocs();
+    bool ok;
+    arena.reset();
+    {
+        JsonDocument doc(&arena);
+        DeserializationError err = msgpack
+            ? deserializeMsgPack(doc, (const uint8_t *)data, len, DeserializationOption::Filter(t->filter))
+            : deserializeJson(doc, (const char *)data, len, DeserializationOption::Filter(t->filter));
+        if (err) {
+            stats.parseErrors++;
+            if (err.code() < GB_PARSE_ERROR_CODES) stats.parseErrorsByCode[err.code()]++;
+            GB_LOG("[GB] %s parse error: %s\n", msgpack ? "MessagePack" : "JSON", err.c_str());
+            return;
+        }
+        t->received++;
+        memset(&event, 0, sizeof(event));
+        ok = t->def->decode(doc.as<JsonObjectConst>(), &event);
+    }
+
+    if (arena.heapAllocs() != heapBefore) {
+        GB_LOG("[GB] Arena overflow: %u heap allocs (peak %u/%u bytes)\n",
+            (unsigned)(arena.heapAllocs() - heapBefore), (unsigned)arena.peak(),
+            (unsigned)arena.capacity());
+    }
+    if (ok) emit(&event);
+}
+
+void gb_protocol_handle_json(const char *json, size_t len) {
+    // Resolve atob("...") and \xNN escapes into plain UTF-8 JSON in one pass
+    int jsonLen = gb_decode_json(json, len, jsonBuf, sizeof(jsonBuf), textLimit);
+    if (jsonLen < 0) {
+        stats.oversized++;
+        GB_LOG("[GB] Message too large after decoding\n");
+        return;
+    }
+
+    char type[GB_TYPE_NAME_MAX];
+    if (!gb_peek_type(jsonBuf, type, sizeof(type))) {
+        stats.parseErrors++;
+        GB_LOG("[GB] Message without a top-level \"t\"\n");
+        return;
+    }
+
+    const gb_type_t *t = gb_find_type(type);
+    if (!t) {
+        stats.unknownTypes++;
+        GB_LOG("[GB] Unknown type: %s\n", type);
+        return;
+    }
+
+    decodeMessage(t, jsonBuf, jsonLen, false);
+}
+
+void gb_protocol_feed(const char *data, size_t len) {
+    size_t off = 0;
+    while (off < len) {
+        gb_line_t line;
+        off += gb_framer_feed(&framer, &data[off], len - off, &line);
+        if (!line.data) continue;
+
+        GB_LOG("[GB] Recv: %s\n", line.data);
+
+        if (line.kind == GB_LINE_GB) {
+            gb_protocol_handle_json(line.data, line.len);
+        }
+        // setTime(epoch);E.setTimeZone(tz);...
+        else if (line.kind == GB_LINE_SETTIME) {
+            memset(&event, 0, sizeof(event));
+            if (gb_parse_settime(&line, &event.time.ts, &event.time.tzHours)) {
+                event.kind = GB_EVT_SET_TIME;
+                event.time.hasZone = true;
+                emit(&event);
+            }
+        }
+    }
+}
+
+void gb_protocol_handle_msgpack(const uint8_t *data, size_t len) {
+    char type[GB_TYPE_NAME_MAX];
+    if (!gb_peek_type_msgpack(data, len, type, sizeof(type))) {
+        stats.parseErrors++;
+        GB_LOG("[GB] Binary message without a leading \"t\"\n");
+        return;
+    }
+
+    const gb_type_t *t = gb_find_type(type);
+    if (!t) {
+        stats.unknownTypes++;
+        GB_LOG("[GB] Unknown type: %s\n", type);
+        return;
+    }
+    decodeMessage(t, data, len, true);
+}
+
+void gb_protocol_feed_binary(const uint8_t *data, size_t len) {
+    size_t off = 0;
+    while (off < len) {
+        const uint8_t *frame;
+        size_t frameLen;
+        off += gb_bin_framer_feed(&binFramer, &data[off], len - off, &frame, &frameLen);
+        if (frame) gb_protocol_handle_msgpack(frame, frameLen);
+    }
+}
+
+void gb_protocol_set_text_limit(size_t bytes) {
+    textLimit = bytes;
+}
+
+void gb_protocol_get_stats(gb_protocol_stats_t *out) {
+    *out = stats;
+    out->lines = framer.lines;
+    out->overlong = framer.overflows;
+    out->binFrames = binFramer.frames;
+    out->binOverlong = binFramer.overflows;
+    out->heapAllocs = arena.heapAllocs();
+    out->arenaPeak = arena.peak();
+}
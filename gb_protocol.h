@@ -0,0 +1,331 @@
+#pragma once
+
+// Bangle.js / Gadgetbridge protocol layer: line framing, escape decoding,
+// JSON parsing and type dispatch into typed events.
+// Portable: no Arduino or BLE dependencies, everything works on fixed buffers,
+// so it builds and runs unchanged on a host.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ArduinoJson.h>
+
+// ---- Message payloads ----
+
+// Field capacities (bytes, including the terminator). Longer text is cut
+// at a UTF-8 boundary.
+#define BT_SRC_MAX      32
+#define BT_SENDER_MAX   64
+#define BT_TITLE_MAX    96
+#define BT_BODY_MAX     256
+#define BT_ARTIST_MAX   64
+#define BT_TRACK_MAX    96
+#define BT_WEATHER_MAX  48
+#define BT_CALL_CMD_MAX 16
+#define BT_CALL_NAME_MAX 64
+
+// Notification from phone
+struct bt_notification_t {
+    uint32_t id;
+    char src[BT_SRC_MAX];       // App name (e.g. "WhatsApp")
+    char sender[BT_SENDER_MAX];
+    char title[BT_TITLE_MAX];
+    char body[BT_BODY_MAX];
+};
+
+// Music playback info
+struct bt_music_t {
+    char artist[BT_ARTIST_MAX];
+    char track[BT_TRACK_MAX];
+    int duration;   // seconds
+    int position;   // seconds
+    bool playing;
+};
+
+// Weather info
+struct bt_weather_t {
+    int temp;       // Celsius
+    int humidity;
+    char txt[BT_WEATHER_MAX];   // Description ("Sunny", "Cloudy", etc.)
+    int code;       // Weather code
+    bool valid;
+};
+
+// Call state
+struct bt_call_t {
+    char cmd[BT_CALL_CMD_MAX];  // "incoming", "accept", "reject", "start", "end"
+    char name[BT_CALL_NAME_MAX];
+    bool active;
+};
+
+// Time sync
+struct bt_time_t {
+    long ts;        // UTC epoch seconds
+    float tzHours;  // offset from E.setTimeZone()
+    bool hasZone;   // false for GB({t:"setTime"}), which carries no zone
+};
+
+enum gb_event_kind_t {
+    GB_EVT_NONE = 0,
+    GB_EVT_NOTIFY,
+    GB_EVT_NOTIFY_DISMISS,
+    GB_EVT_MUSIC_INFO,
+    GB_EVT_MUSIC_STATE,
+    GB_EVT_WEATHER,
+    GB_EVT_CALL,
+    GB_EVT_FIND,
+    GB_EVT_GPS_QUERY,
+    GB_EVT_SET_TIME,
+};
+
+// One decoded phone -> watch message
+struct gb_event_t {
+    gb_event_kind_t kind;
+    union {
+        bt_notification_t notify;   // NOTIFY; only .id for NOTIFY_DISMISS
+        bt_music_t music;           // MUSIC_INFO; only .playing for MUSIC_STATE
+        bt_weather_t weather;
+        bt_call_t call;
+        bt_time_t time;
+        bool find;
+    };
+};
+
+// Longest line we keep; longer lines are dropped whole
+#define GB_LINE_MAX 2048
+
+enum gb_line_kind_t {
+    GB_LINE_OTHER = 0,
+    GB_LINE_GB,         // GB({...}) — data points at the JSON between the parentheses
+    GB_LINE_SETTIME,    // setTime(epoch);E.setTimeZone(tz);...
+};
+
+// View into the framer's buffer, valid until the next gb_framer_feed() call.
+// The text is NUL-terminated and may be modified in place by the consumer.
+struct gb_line_t {
+    char *data;
+    size_t len;
+    gb_line_kind_t kind;
+};
+
+// Fixed-capacity line framer
+struct gb_framer_t {
+    char buf[GB_LINE_MAX + 1];
+    size_t len;
+    bool overflow;          // current line is too long and is being discarded
+    uint32_t lines;         // complete lines framed
+    uint32_t overflows;     // lines dropped for being longer than GB_LINE_MAX
+};
+
+void gb_framer_reset(gb_framer_t *f);
+
+// Consume bytes until a line completes or the input runs out and return the
+// number of bytes consumed. line->data is non-null only when a non-empty line
+// was completed. Call repeatedly until the whole input has been consumed.
+size_t gb_framer_feed(gb_framer_t *f, const char *data, size_t len, gb_line_t *line);
+
+// Worst case output of gb_decode_json(): escapes and atob() expand by at most 3/2
+#define GB_JSON_MAX (GB_LINE_MAX * 3 / 2 + 16)
+
+// Display limit for atob() text, in UTF-8 bytes, under keys that are not an event
+// field; known keys ("src", "title", "body", ...) are cut to what their field holds
+#define GB_TEXT_LIMIT (BT_BODY_MAX - 1)
+
+// Rewrite a GB() payload into plain JSON in a single pass: atob("...") becomes a
+// JSON string, \xNN escapes are resolved, and Latin-1 text is converted to UTF-8.
+// atob() text is cut on a character boundary and ends in "…" when it is longer
+// than the event field its key lands in, or than `textLimit` UTF-8 bytes
+// (0 = no limits at all). Malformed base64 is decoded as far as it
+// goes; stray characters are skipped. Returns the output length
+// (NUL-terminated), or -1 if `out` is too small.
+int gb_decode_json(const char *in, size_t len, char *out, size_t outSize, size_t textLimit = 0);
+
+// Parse "setTime(epoch);E.setTimeZone(hours);..." into a UTC timestamp and offset
+bool gb_parse_settime(const gb_line_t *line, long *ts, float *tzHours);
+
+// ---- Binary channel ----
+
+// Optional compact channel: each frame is a little-endian uint16 length followed
+// by a MessagePack map with the same keys as the GB() JSON messages. "t" must be
+// the first key. Strings are UTF-8 as is; nothing is escaped or base64-encoded.
+#define GB_BIN_FRAME_MAX 1024
+
+struct gb_bin_framer_t {
+    uint8_t buf[GB_BIN_FRAME_MAX];
+    size_t len;             // payload bytes received so far
+    size_t need;            // payload length from the header
+    uint8_t header[2];
+    uint8_t headerLen;
+    uint32_t frames;        // complete frames
+    uint32_t overflows;     // frames dropped for being longer than GB_BIN_FRAME_MAX
+};
+
+void gb_bin_framer_reset(gb_bin_framer_t *f);
+
+// Same contract as gb_framer_feed(): returns bytes consumed, *frame is non-null
+// only when a frame was completed
+size_t gb_bin_framer_feed(gb_bin_framer_t *f, const uint8_t *data, size_t len,
+                          const uint8_t **frame, size_t *frameLen);
+
+// Read the "t" value at the start of a MessagePack map without parsing the rest
+bool gb_peek_type_msgpack(const uint8_t *data, size_t len, char *type, size_t size);
+
+// ---- JSON decoding ----
+
+// Bump allocator for ArduinoJson backed by a fixed buffer. Reset it between
+// messages once the JsonDocument using it is gone. Requests that do not fit
+// spill to the heap and are counted, so heapAllocs() staying at 0 proves a
+// message was decoded without touching the heap.
+class GbArena : public ArduinoJson::Allocator {
+public:
+    GbArena(uint8_t *buf, size_t size) : _buf(buf), _size(size) {}
+
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t newSize) override;
+
+    void reset() { _top = 0; _last = nullptr; }
+    size_t used() const { return _top; }
+    size_t peak() const { return _peak; }
+    size_t capacity() const { return _size; }
+    uint32_t heapAllocs() const { return _heapAllocs; }
+
+private:
+    bool owns(const void *ptr) const {
+        return ptr >= _buf && ptr < _buf + _size;
+    }
+
+    uint8_t *_buf;
+    size_t _size;
+    size_t _top = 0;
+    size_t _peak = 0;
+    uint8_t *_last = nullptr;   // most recent block, can grow or shrink in place
+    uint32_t _heapAllocs = 0;
+};
+
+// Copy the value of the top-level "t" key into `type` without parsing the message
+bool gb_peek_type(const char *json, char *type, size_t size);
+
+// Build an ArduinoJson filter that keeps only "t" plus the listed keys.
+// `keys` is nullptr-terminated.
+void gb_build_filter(JsonDocument &filter, const char *const *keys);
+
+// strlcpy() that never cuts a UTF-8 sequence in half
+size_t gb_copy_utf8(char *dst, size_t size, const char *src);
+
+// ---- Message type dispatch ----
+
+// Open-addressed table keyed by a seeded hash of "t". The seed is searched at
+// compile time so every built-in type lands in its own slot (one probe, a
+// perfect hash); types registered later fall back to linear probing.
+#define GB_TYPE_SLOTS 32
+#define GB_TYPE_MAX_KEYS 6
+#define GB_TYPE_NAME_MAX 16   // "t" values up to 15 characters
+#define GB_TYPE_SEED_SEARCH 256
+
+// Fill `evt` from a filtered message; return false to drop it
+typedef bool (*gb_decoder_t)(JsonObjectConst msg, gb_event_t *evt);
+
+struct gb_type_def_t {
+    const char *type;
+    const char *keys[GB_TYPE_MAX_KEYS + 1];   // fields to keep, nullptr-terminated
+    gb_decoder_t decode;
+};
+
+struct gb_type_t {
+    const gb_type_def_t *def;
+    JsonDocument filter;
+    mutable uint32_t received = 0;  // messages of this type that parsed
+};
+
+constexpr uint32_t GB_FNV_BASIS = 2166136261u;
+
+// FNV-1a with the offset basis used as seed
+constexpr uint32_t gb_type_hash(const char *s, uint32_t seed) {
+    uint32_t h = seed;
+    while (*s) {
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    }
+    return h;
+}
+
+constexpr bool gb_types_collision_free(const gb_type_def_t *defs, size_t count, uint32_t seed) {
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            if ((gb_type_hash(defs[i].type, seed) & (GB_TYPE_SLOTS - 1)) ==
+                (gb_type_hash(defs[j].type, seed) & (GB_TYPE_SLOTS - 1))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// First seed that gives every type in `defs` its own slot, 0 if there is none
+constexpr uint32_t gb_perfect_seed(const gb_type_def_t *defs, size_t count) {
+    for (uint32_t seed = GB_FNV_BASIS; seed < GB_FNV_BASIS + GB_TYPE_SEED_SEARCH; seed++) {
+        if (gb_types_collision_free(defs, count, seed)) return seed;
+    }
+    return 0;
+}
+
+// Clear the table and set the hash seed (from gb_perfect_seed())
+void gb_init_types(uint32_t seed);
+
+// Add a message type. `def` must stay valid for the lifetime of the program.
+// Returns false if the name is empty or GB_TYPE_NAME_MAX long or more, the
+// type already exists or the table is full. The table is not locked: register
+// before anything is fed to the protocol.
+bool gb_register_type(const gb_type_def_t *def);
+
+// Look up a registered type, nullptr if unknown
+const gb_type_t *gb_find_type(const char *type);
+
+// Table slot `slot` (0..GB_TYPE_SLOTS-1), nullptr if empty; for walking all types
+const gb_type_t *gb_type_at(size_t slot);
+
+// ---- Protocol pipeline ----
+
+// Receives every decoded event
+typedef void (*gb_event_sink_t)(const gb_event_t *evt);
+// printf-style diagnostics, may be nullptr
+typedef void (*gb_log_t)(const char *fmt, ...);
+
+// One counter per DeserializationError::Code (Ok .. TooDeep)
+#define GB_PARSE_ERROR_CODES 6
+
+struct gb_protocol_stats_t {
+    uint32_t lines;         // complete lines framed
+    uint32_t overlong;      // lines dropped by the framer
+    uint32_t messages;      // events emitted
+    uint32_t oversized;     // payloads that did not fit GB_JSON_MAX after decoding
+    uint32_t parseErrors;
+    uint32_t parseErrorsByCode[GB_PARSE_ERROR_CODES];
+    uint32_t unknownTypes;
+    uint32_t binFrames;     // frames on the binary channel
+    uint32_t binOverlong;   // binary frames dropped by the framer
+    uint32_t heapAllocs;    // arena spills to the heap, should stay 0
+    uint32_t arenaPeak;     // bytes
+};
+
+// Register the built-in message types and set where events go
+void gb_protocol_init(gb_event_sink_t sink, gb_log_t log);
+
+// Drop any partially received line or frame (on connect / disconnect)
+void gb_protocol_reset();
+
+// Display limit for atob() text (default GB_TEXT_LIMIT, 0 = keep everything that fits)
+void gb_protocol_set_text_limit(size_t bytes);
+
+// Frame, decode and dispatch raw bytes from the phone
+void gb_protocol_feed(const char *data, size_t len);
+
+// Parse one GB() payload (without the GB( ) wrapper); emits at most one event
+void gb_protocol_handle_json(const char *json, size_t len);
+
+// Frame and dispatch bytes from the binary channel
+void gb_protocol_feed_binary(const uint8_t *data, size_t len);
+
+// Decode one MessagePack message; emits at most one event
+void gb_protocol_handle_msgpack(const uint8_t *data, size_t len);
+
+void gb_protocol_get_stats(gb_protocol_stats_t *stats);
@@ -0,0 +1,64 @@
+#include "notification_dedup.h"
+
+struct DedupEntry {
+    uint32_t id;
+    uint32_t hash;
+};
+
+// Most recently seen first
+static DedupEntry recent[NOTIF_DEDUP_ENTRIES];
+static int recentCount = 0;
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+
+static uint32_t contentHash(const bt_notification_t *n) {
+    // Chain FNV-1a over the fields; the separator keeps "ab"+"c" apart from "a"+"bc"
+    const char *fields[] = { n->src, n->sender, n->title, n->body };
+    uint32_t h = GB_FNV_BASIS;
+    for (const char *field : fields) {
+        h = gb_type_hash(field, h);
+        h = (h ^ 0x1f) * 16777619u;
+    }
+    return h;
+}
+
+// Index of the entry, or recentCount if it isn't there
+static int findEntry(const DedupEntry &entry) {
+    int i = 0;
+    while (i < recentCount && (recent[i].id != entry.id || recent[i].hash != entry.hash)) i++;
+    return i;
+}
+
+// Move entry i to the front; i == recentCount adds it, pushing out the least recently seen one
+static void moveToFront(int i, const DedupEntry &entry) {
+    if (i == recentCount) {
+        if (recentCount < NOTIF_DEDUP_ENTRIES) recentCount++;
+        i = recentCount - 1;
+    }
+    memmove(&recent[1], &recent[0], i * sizeof(DedupEntry));
+    recent[0] = entry;
+}
+
+bool notification_dedup_check(const bt_notification_t *notif) {
+    DedupEntry entry = { notif->id, contentHash(notif) };
+    int i = findEntry(entry);
+    if (i == recentCount) return true;
+
+    moveToFront(i, entry);
+    hits++;
+    return false;
+}
+
+void notification_dedup_record(const bt_notification_t *notif) {
+    DedupEntry entry = { notif->id, contentHash(notif) };
+    moveToFront(findEntry(entry), entry);
+    misses++;
+}
+
+uint32_t notification_dedup_hits() {
+    return hits;
+}
+
+uint32_t notification_dedup_misses() {
+    return misses;
+}
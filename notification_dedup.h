@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+#include "gb_protocol.h"
+
+// Recently seen notifications, keyed on id + content hash.
+// Gadgetbridge re-sends what the watch already showed after every reconnect;
+// those are dropped before they reach the store or the UI. An id that comes
+// back with different content is an update and passes through.
+#define NOTIF_DEDUP_ENTRIES 32   // LRU of (id, hash) pairs
+
+// True if the notification has not been seen recently, false if it is a duplicate
+bool notification_dedup_check(const bt_notification_t *notif);
+
+// Remember a notification once it has been accepted, so a copy that never
+// made it to the UI is not dropped when the phone re-sends it
+void notification_dedup_record(const bt_notification_t *notif);
+
+uint32_t notification_dedup_hits();     // duplicates dropped
+uint32_t notification_dedup_misses();   // new notifications passed through
@@ -0,0 +1,209 @@
+#include "notification_log.h"
+#include <SD_MMC.h>
+#include <FS.h>
+#include "HWCDC.h"
+#include "sd_card.h"
+#include "rtc_clock.h"
+#include "notification_store.h"
+
+extern HWCDC USBSerial;
+
+#define LOG_PATH      "/notif.log"
+#define IDX_PATH      "/notif.idx"
+#define LOG_OLD_PATH  "/notif.log.old"
+#define IDX_OLD_PATH  "/notif.idx.old"
+
+// Batch buffer: enough for several worst-case records
+#define PENDING_BYTES    4096
+#define PENDING_RECORDS  32
+
+// Record: uint16 payload length, then payload =
+//   uint32 id, uint32 timestamp, src\0 sender\0 title\0 body\0
+#define RECORD_HEADER    2
+#define RECORD_FIXED     8
+#define RECORD_MAX       (RECORD_HEADER + RECORD_FIXED + BT_SRC_MAX + BT_SENDER_MAX + BT_TITLE_MAX + BT_BODY_MAX)
+
+static bool ready = false;
+static uint32_t logSize = 0;        // bytes already on the card
+static int idxCount = 0;            // records already on the card
+
+static uint8_t pending[PENDING_BYTES];
+static size_t pendingLen = 0;
+static uint32_t pendingOffsets[PENDING_RECORDS];
+static int pendingCount = 0;
+static uint32_t firstPendingMs = 0;
+
+static void rotate() {
+    SD_MMC.remove(LOG_OLD_PATH);
+    SD_MMC.remove(IDX_OLD_PATH);
+    SD_MMC.rename(LOG_PATH, LOG_OLD_PATH);
+    SD_MMC.rename(IDX_PATH, IDX_OLD_PATH);
+    logSize = 0;
+    idxCount = 0;
+    USBSerial.println("[LOG] Notification log rotated");
+}
+
+void notification_log_init() {
+    if (!sd_card_is_mounted()) {
+        USBSerial.println("[LOG] No SD card, notification log disabled");
+        return;
+    }
+
+    // Only the sizes are needed at boot; records are read on demand
+    File f = SD_MMC.open(LOG_PATH, FILE_READ);
+    logSize = f ? f.size() : 0;
+    if (f) f.close();
+    f = SD_MMC.open(IDX_PATH, FILE_READ);
+    size_t idxSize = f ? f.size() : 0;
+    idxCount = idxSize / sizeof(uint32_t);
+    if (f) f.close();
+
+    ready = true;
+    // A torn index entry (power lost mid-flush) would misalign every later one
+    if (idxSize % sizeof(uint32_t)) rotate();
+    USBSerial.printf("[LOG] Notification log: %d records, %u bytes\n", idxCount, (unsigned)logSize);
+}
+
+// Append `data` to a file that held `base` bytes before this batch, resuming
+// after whatever an earlier failed attempt already got onto the card
+static bool appendFrom(const char *path, uint32_t base, const uint8_t *data, size_t len) {
+    File f = SD_MMC.open(path, FILE_APPEND);
+    if (!f) return false;
+    size_t done = f.size() > base ? f.size() - base : 0;
+    if (done > len) done = len;
+    size_t written = f.write(data + done, len - done);
+    f.close();
+    return done + written == len;
+}
+
+void notification_log_flush() {
+    if (!ready || pendingCount == 0) return;
+
+    uint32_t start = millis();
+    bool ok = appendFrom(LOG_PATH, logSize, pending, pendingLen) &&
+              appendFrom(IDX_PATH, idxCount * sizeof(uint32_t), (const uint8_t *)pendingOffsets,
+                         pendingCount * sizeof(uint32_t));
+    if (!ok) {
+        // Keep the batch; the next flush picks up where each file stopped
+        USBSerial.println("[LOG] SD write failed");
+        firstPendingMs = millis();
+        return;
+    }
+
+    USBSerial.printf("[LOG] Flushed %d records (%u bytes) in %lu ms\n",
+        pendingCount, (unsigned)pendingLen, millis() - start);
+    logSize += pendingLen;
+    idxCount += pendingCount;
+    pendingLen = 0;
+    pendingCount = 0;
+
+    if (logSize >= NOTIF_LOG_MAX_BYTES) rotate();
+}
+
+static size_t putString(uint8_t *dst, const char *s) {
+    size_t n = strlen(s) + 1;
+    memcpy(dst, s, n);
+    return n;
+}
+
+void notification_log_append(const bt_notification_t *notif) {
+    if (!ready) return;
+
+    if (pendingCount == PENDING_RECORDS || pendingLen + RECORD_MAX > PENDING_BYTES) {
+        notification_log_flush();
+        if (pendingCount == PENDING_RECORDS || pendingLen + RECORD_MAX > PENDING_BYTES) return;
+    }
+
+    uint8_t *rec = &pending[pendingLen];
+    uint8_t *p = rec + RECORD_HEADER;
+    uint32_t ts = rtc_get_epoch();
+    memcpy(p, &notif->id, 4);
+    memcpy(p + 4, &ts, 4);
+    p += RECORD_FIXED;
+    p += putString(p, notif->src);
+    p += putString(p, notif->sender);
+    p += putString(p, notif->title);
+    p += putString(p, notif->body);
+
+    uint16_t payload = p - rec - RECORD_HEADER;
+    memcpy(rec, &payload, RECORD_HEADER);
+
+    if (pendingCount == 0) firstPendingMs = millis();
+    pendingOffsets[pendingCount++] = logSize + pendingLen;
+    pendingLen += RECORD_HEADER + payload;
+}
+
+void notification_log_tick() {
+    if (pendingCount > 0 && millis() - firstPendingMs >= NOTIF_LOG_FLUSH_MS) {
+        notification_log_flush();
+    }
+}
+
+int notification_log_count() {
+    return idxCount + pendingCount;
+}
+
+// Split a record payload back into a notification
+static bool decodeRecord(const uint8_t *payload, size_t len, bt_notification_t *out, uint32_t *timestamp) {
+    if (len < RECORD_FIXED + 4) return false;
+    memcpy(&out->id, payload, 4);
+    if (timestamp) memcpy(timestamp, payload + 4, 4);
+
+    const char *s = (const char *)payload + RECORD_FIXED;
+    const char *end = (const char *)payload + len;
+    char *fields[4] = { out->src, out->sender, out->title, out->body };
+    size_t sizes[4] = { sizeof(out->src), sizeof(out->sender), sizeof(out->title), sizeof(out->body) };
+    for (int i = 0; i < 4; i++) {
+        const char *z = (const char *)memchr(s, '\0', end - s);
+        if (!z) return false;
+        gb_copy_utf8(fields[i], sizes[i], s);
+        s = z + 1;
+    }
+    return true;
+}
+
+bool notification_log_read(int nth, bt_notification_t *out, uint32_t *timestamp) {
+    if (!ready || nth < 0 || nth >= notification_log_count()) return false;
+
+    // Newest records may still be in the batch buffer
+    if (nth < pendingCount) {
+        const uint8_t *rec = &pending[pendingOffsets[pendingCount - 1 - nth] - logSize];
+        uint16_t payload;
+        memcpy(&payload, rec, RECORD_HEADER);
+        return decodeRecord(rec + RECORD_HEADER, payload, out, timestamp);
+    }
+
+    int record = idxCount - 1 - (nth - pendingCount);
+    uint32_t offset;
+    File idx = SD_MMC.open(IDX_PATH, FILE_READ);
+    if (!idx) return false;
+    bool ok = idx.seek(record * sizeof(uint32_t)) && idx.read((uint8_t *)&offset, 4) == 4;
+    idx.close();
+    if (!ok) return false;
+
+    uint8_t buf[RECORD_MAX];
+    uint16_t payload;
+    File log = SD_MMC.open(LOG_PATH, FILE_READ);
+    if (!log) return false;
+    ok = log.seek(offset) && log.read((uint8_t *)&payload, RECORD_HEADER) == RECORD_HEADER &&
+         payload <= sizeof(buf) && log.read(buf, payload) == payload;
+    log.close();
+    return ok && decodeRecord(buf, payload, out, timestamp);
+}
+
+void notification_log_restore(int max) {
+    int n = notification_log_count();
+    if (n > max) n = max;
+
+    // Oldest first, so the newest ends up on top of the store
+    bt_notification_t notif;
+    int restored = 0;
+    for (int nth = n - 1; nth >= 0; nth--) {
+        memset(&notif, 0, sizeof(notif));
+        if (!notification_log_read(nth, &notif, nullptr)) continue;
+        notification_store_add(&notif);
+        notification_dedup_record(&notif);  // the phone re-sends these after connecting
+        restored++;
+    }
+    if (restored) USBSerial.printf("[LOG] Restored %d notifications\n", restored);
+}
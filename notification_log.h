@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+#include "gb_protocol.h"
+#include "notification_dedup.h"
+
+// Append-only notification history on the SD card.
+// /notif.log holds length-prefixed records, /notif.idx one uint32 file offset
+// per record, so the latest entries can be read back without parsing the log.
+// Appends are buffered in RAM and written in one batch on a timer or before sleep.
+#define NOTIF_LOG_FLUSH_MS    15000        // max time a record waits in RAM
+#define NOTIF_LOG_MAX_BYTES   (512 * 1024) // rotate to .old beyond this
+#define NOTIF_LOG_RESTORE     NOTIF_DEDUP_ENTRIES  // records put back into the store at boot
+
+void notification_log_init();
+void notification_log_append(const bt_notification_t *notif);
+void notification_log_tick();   // call from loop; flushes when the batch is due
+void notification_log_flush();  // write the pending batch now (e.g. before sleep)
+
+// Records in the log, including ones not yet flushed
+int notification_log_count();
+
+// nth most recent record (0 = newest). `timestamp` is RTC local time, may be null.
+bool notification_log_read(int nth, bt_notification_t *out, uint32_t *timestamp);
+
+// Put the latest `max` records back into the notification store (after
+// notification_store_init()) and mark them as seen
+void notification_log_restore(int max);
@@ -0,0 +1,256 @@
+#include "notification_rules.h"
+#include <SD_MMC.h>
+#include <FS.h>
+#include <Preferences.h>
+#include "HWCDC.h"
+#include "sd_card.h"
+#include "rtc_clock.h"
+
+extern HWCDC USBSerial;
+
+#define RULES_VERSION     1
+#define RULES_NVS_NS      "notif_rules"
+#define RULES_NVS_KEY     "blob"
+#define MINUTES_PER_DAY   1440
+
+enum : uint8_t {
+    ACTION_DEFAULT = 0,   // only a rate limit for this app
+    ACTION_ALLOW,
+    ACTION_DENY,
+};
+
+struct AppRule {
+    uint32_t hash;          // gb_type_hash() of the app name
+    uint8_t action;
+    uint8_t rateCount;      // 0 = no limit
+    uint16_t rateWindowS;
+};
+
+// What gets stored in NVS
+struct RulesBlob {
+    uint8_t version;
+    uint8_t defaultDeny;
+    uint8_t appCount;
+    uint8_t defaultRateCount;
+    uint16_t defaultRateWindowS;
+    uint8_t quiet[MINUTES_PER_DAY / 8];   // one bit per minute of the day
+    AppRule apps[NOTIF_RULES_MAX_APPS];
+};
+
+// Fixed-window rate state, one per app rule plus the shared default
+struct RateState {
+    uint32_t windowStart;
+    uint8_t count;
+};
+
+static RulesBlob rules;
+static int8_t appIndex[NOTIF_RULES_SLOTS];    // -1 = empty
+static RateState appRate[NOTIF_RULES_MAX_APPS];
+static RateState defaultRate;
+static notif_rules_stats_t stats;
+
+static void clearRules() {
+    memset(&rules, 0, sizeof(rules));
+    rules.version = RULES_VERSION;
+}
+
+static void buildIndex() {
+    memset(appIndex, -1, sizeof(appIndex));
+    for (int i = 0; i < rules.appCount; i++) {
+        uint32_t slot = rules.apps[i].hash;
+        while (appIndex[slot & (NOTIF_RULES_SLOTS - 1)] >= 0) slot++;
+        appIndex[slot & (NOTIF_RULES_SLOTS - 1)] = i;
+    }
+    memset(appRate, 0, sizeof(appRate));
+    memset(&defaultRate, 0, sizeof(defaultRate));
+}
+
+static AppRule *findApp(uint32_t hash) {
+    for (uint32_t slot = hash, probes = 0; probes < NOTIF_RULES_SLOTS; slot++, probes++) {
+        int8_t i = appIndex[slot & (NOTIF_RULES_SLOTS - 1)];
+        if (i < 0) return nullptr;
+        if (rules.apps[i].hash == hash) return &rules.apps[i];
+    }
+    return nullptr;
+}
+
+// Rule for `name`, created if there is room
+static AppRule *appRule(const char *name) {
+    uint32_t hash = gb_type_hash(name, GB_FNV_BASIS);
+    for (int i = 0; i < rules.appCount; i++) {
+        if (rules.apps[i].hash == hash) return &rules.apps[i];
+    }
+    if (rules.appCount == NOTIF_RULES_MAX_APPS) return nullptr;
+    AppRule *rule = &rules.apps[rules.appCount++];
+    rule->hash = hash;
+    return rule;
+}
+
+static void setQuiet(int from, int to) {
+    // Windows may wrap past midnight
+    for (int m = from; m != to; m = (m + 1) % MINUTES_PER_DAY) {
+        rules.quiet[m / 8] |= 1 << (m % 8);
+    }
+}
+
+static bool parseTime(const char *s, int *minute) {
+    int h, m;
+    if (sscanf(s, "%d:%d", &h, &m) != 2 || h < 0 || h > 23 || m < 0 || m > 59) return false;
+    *minute = h * 60 + m;
+    return true;
+}
+
+static bool parseLine(char *line) {
+    // Strip comments and trailing whitespace
+    char *hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    size_t len = strlen(line);
+    while (len > 0 && isspace((uint8_t)line[len - 1])) line[--len] = '\0';
+    while (isspace((uint8_t)*line)) line++;
+    if (!*line) return true;
+
+    char *arg = line;
+    while (*arg && !isspace((uint8_t)*arg)) arg++;
+    if (*arg) *arg++ = '\0';
+    while (isspace((uint8_t)*arg)) arg++;
+
+    if (strcmp(line, "default") == 0) {
+        if (strcmp(arg, "deny") == 0) rules.defaultDeny = 1;
+        else if (strcmp(arg, "allow") == 0) rules.defaultDeny = 0;
+        else return false;
+        return true;
+    }
+    if ((strcmp(line, "allow") == 0 || strcmp(line, "deny") == 0) && *arg) {
+        AppRule *rule = appRule(arg);
+        if (!rule) return false;
+        rule->action = line[0] == 'a' ? ACTION_ALLOW : ACTION_DENY;
+        return true;
+    }
+    if (strcmp(line, "rate") == 0) {
+        int count, window, used = 0;
+        if (sscanf(arg, "%d/%d %n", &count, &window, &used) != 2 || !used || !arg[used] ||
+            count < 1 || count > 255 || window < 1 || window > 65535) {
+            return false;
+        }
+        const char *app = &arg[used];
+        if (strcmp(app, "*") == 0) {
+            rules.defaultRateCount = count;
+            rules.defaultRateWindowS = window;
+            return true;
+        }
+        AppRule *rule = appRule(app);
+        if (!rule) return false;
+        rule->rateCount = count;
+        rule->rateWindowS = window;
+        return true;
+    }
+    if (strcmp(line, "quiet") == 0) {
+        char from[8], to[8];
+        int a, b;
+        if (sscanf(arg, "%7s %7s", from, to) != 2 || !parseTime(from, &a) || !parseTime(to, &b)) return false;
+        setQuiet(a, b);
+        return true;
+    }
+    return false;
+}
+
+static bool loadFromSd() {
+    if (!sd_card_is_mounted()) return false;
+    File f = SD_MMC.open(NOTIF_RULES_PATH, FILE_READ);
+    if (!f) return false;
+
+    clearRules();
+    char line[96];
+    int lineNo = 0;
+    while (f.available()) {
+        size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[n] = '\0';
+        lineNo++;
+        if (!parseLine(line)) {
+            USBSerial.printf("[RULES] %s:%d ignored: %s\n", NOTIF_RULES_PATH, lineNo, line);
+        }
+    }
+    f.close();
+    return true;
+}
+
+// Read the cached rules; false (rules untouched) unless the blob is whole and sane
+static bool loadFromNvs(Preferences &prefs) {
+    RulesBlob saved;
+    if (prefs.getBytesLength(RULES_NVS_KEY) != sizeof(saved) ||
+        prefs.getBytes(RULES_NVS_KEY, &saved, sizeof(saved)) != sizeof(saved)) return false;
+    if (saved.version != RULES_VERSION || saved.appCount > NOTIF_RULES_MAX_APPS) return false;
+    for (int i = 0; i < saved.appCount; i++) {
+        if (saved.apps[i].action > ACTION_DENY) return false;
+    }
+    rules = saved;
+    return true;
+}
+
+void notification_rules_init() {
+    Preferences prefs;
+    prefs.begin(RULES_NVS_NS, false);
+
+    if (loadFromSd()) {
+        // Cache for boots without the card; only write when something changed
+        RulesBlob saved;
+        if (prefs.getBytes(RULES_NVS_KEY, &saved, sizeof(saved)) != sizeof(saved) ||
+            memcmp(&saved, &rules, sizeof(rules)) != 0) {
+            prefs.putBytes(RULES_NVS_KEY, &rules, sizeof(rules));
+        }
+        USBSerial.printf("[RULES] Loaded %d app rules from %s\n", rules.appCount, NOTIF_RULES_PATH);
+    } else if (loadFromNvs(prefs)) {
+        USBSerial.printf("[RULES] Loaded %d app rules from NVS\n", rules.appCount);
+    } else {
+        // No card and no usable cache (the card was tried first): defaults
+        clearRules();
+    }
+    prefs.end();
+    buildIndex();
+}
+
+// Count one more notification in the window; false once the limit is reached
+static bool rateAllows(RateState *state, uint8_t limit, uint16_t windowS) {
+    if (limit == 0) return true;
+    uint32_t now = millis();
+    if (state->count == 0 || now - state->windowStart >= (uint32_t)windowS * 1000) {
+        state->windowStart = now;
+        state->count = 0;
+    }
+    if (state->count >= limit) return false;
+    state->count++;
+    return true;
+}
+
+notif_rule_result_t notification_rules_evaluate(const bt_notification_t *notif) {
+    AppRule *rule = findApp(gb_type_hash(notif->src, GB_FNV_BASIS));
+
+    bool deny = rules.defaultDeny;
+    if (rule && rule->action == ACTION_ALLOW) deny = false;
+    if (rule && rule->action == ACTION_DENY) deny = true;
+    if (deny) {
+        stats.dropped++;
+        return NOTIF_RULE_DROP;
+    }
+
+    int minute = rtc_minute_of_day();
+    if (minute >= 0 && (rules.quiet[minute / 8] & (1 << (minute % 8)))) {
+        stats.quiet++;
+        return NOTIF_RULE_SILENT;
+    }
+
+    bool allowed = rule && rule->rateCount
+        ? rateAllows(&appRate[rule - rules.apps], rule->rateCount, rule->rateWindowS)
+        : rateAllows(&defaultRate, rules.defaultRateCount, rules.defaultRateWindowS);
+    if (!allowed) {
+        stats.rateLimited++;
+        return NOTIF_RULE_SILENT;
+    }
+
+    stats.shown++;
+    return NOTIF_RULE_SHOW;
+}
+
+void notification_rules_get_stats(notif_rules_stats_t *out) {
+    *out = stats;
+}
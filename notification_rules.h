@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include "gb_protocol.h"
+
+// Notification rules, applied in the BLE layer before anything wakes the screen.
+// Written as text in /notif_rules.txt on the SD card, one rule per line:
+//
+//   default allow            # or deny: what happens to apps not listed below
+//   deny Facebook            # never store or show
+//   allow Messages           # always passes (with "default deny")
+//   rate 5/60 WhatsApp       # at most 5 shown per 60 s, the rest are kept silently
+//   rate 20/300 *            # shared limit for apps without their own rule
+//   quiet 22:30 07:00        # store silently in this window (RTC local time)
+//
+// The parsed rules are cached in NVS as a compact blob (app names are kept as
+// 32-bit hashes, quiet hours as a minute bitmap), so they also apply without a
+// card. Evaluation is a hash lookup plus a bit test per message.
+#define NOTIF_RULES_PATH      "/notif_rules.txt"
+#define NOTIF_RULES_MAX_APPS  32
+#define NOTIF_RULES_SLOTS     64     // app index, power of two
+
+enum notif_rule_result_t {
+    NOTIF_RULE_SHOW = 0,    // store, wake the screen and show a card
+    NOTIF_RULE_SILENT,      // store and log only (quiet hours, rate limited)
+    NOTIF_RULE_DROP,        // denied: discard
+};
+
+struct notif_rules_stats_t {
+    uint32_t shown;
+    uint32_t quiet;
+    uint32_t rateLimited;
+    uint32_t dropped;
+};
+
+void notification_rules_init();   // after sd_card_init()
+
+// Decide what to do with an incoming notification (protocol task)
+notif_rule_result_t notification_rules_evaluate(const bt_notification_t *notif);
+
+void notification_rules_get_stats(notif_rules_stats_t *stats);
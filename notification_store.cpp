@@ -0,0 +1,260 @@
+#include "notification_store.h"
+#include "HWCDC.h"
+#include <esp_heap_caps.h>
+
+extern HWCDC USBSerial;
+
+// Id index: linear probing, kept at most half full
+#define INDEX_SLOTS   256
+#define INDEX_EMPTY   0xFFFF
+
+static_assert(INDEX_SLOTS >= NOTIF_STORE_CAPACITY * 2, "id index must stay at most half full");
+
+// Entry slots form a FIFO ring in arrival order; text is allocated from the
+// slab in the same order, so evicting the oldest entry always frees the
+// oldest text.
+struct Entry {
+    uint32_t id;
+    uint32_t textOff;       // sender\0title\0body\0 in the slab
+    uint16_t textLen;
+    uint16_t titleRel;
+    uint16_t bodyRel;
+    uint8_t app;            // index into apps[]
+    uint8_t live;           // 0 once dismissed (text is reclaimed when it ages out)
+};
+
+struct App {
+    uint32_t hash;
+    uint16_t refs;
+    char name[BT_SRC_MAX];
+};
+
+struct StoreMem {
+    Entry entries[NOTIF_STORE_CAPACITY];
+    uint16_t index[INDEX_SLOTS];
+    App apps[NOTIF_STORE_MAX_APPS];
+    char slab[NOTIF_STORE_SLAB_SIZE];
+};
+
+static StoreMem *mem = nullptr;
+static int ringHead = 0;      // next entry slot
+static int ringCount = 0;     // entries in the ring, live or not
+static int liveCount = 0;
+static uint32_t slabHead = 0; // next free text byte
+
+// ---- Id index ----
+
+static uint32_t indexHome(uint32_t id) {
+    return (id * 2654435761u) >> 24;  // top 8 bits, INDEX_SLOTS == 256
+}
+
+static int indexFind(uint32_t id) {
+    for (uint32_t i = indexHome(id), n = 0; n < INDEX_SLOTS; i = (i + 1) & (INDEX_SLOTS - 1), n++) {
+        uint16_t e = mem->index[i];
+        if (e == INDEX_EMPTY) return -1;
+        if (mem->entries[e].id == id) return i;
+    }
+    return -1;
+}
+
+static void indexInsert(uint32_t id, uint16_t entry) {
+    uint32_t i = indexHome(id);
+    while (mem->index[i] != INDEX_EMPTY) i = (i + 1) & (INDEX_SLOTS - 1);
+    mem->index[i] = entry;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void indexErase(int slot) {
+    uint32_t i = slot;
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & (INDEX_SLOTS - 1);
+        uint16_t e = mem->index[j];
+        if (e == INDEX_EMPTY) break;
+        uint32_t home = indexHome(mem->entries[e].id);
+        // Move e back into the hole unless its home lies cyclically in (i, j]
+        bool stays = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            mem->index[i] = e;
+            i = j;
+        }
+    }
+    mem->index[i] = INDEX_EMPTY;
+}
+
+// ---- Ring / slab ----
+
+static int oldestSlot() {
+    return (ringHead - ringCount + NOTIF_STORE_CAPACITY) % NOTIF_STORE_CAPACITY;
+}
+
+static void evictOldest() {
+    Entry &e = mem->entries[oldestSlot()];
+    if (e.live) {
+        int slot = indexFind(e.id);
+        if (slot >= 0) indexErase(slot);
+        liveCount--;
+    }
+    mem->apps[e.app].refs--;
+    ringCount--;
+    if (ringCount == 0) slabHead = 0;
+}
+
+// ---- Interned app names ----
+
+static uint32_t nameHash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+static uint8_t internApp(const char *name) {
+    uint32_t h = nameHash(name);
+    int freeSlot = -1;
+    for (int i = 0; i < NOTIF_STORE_MAX_APPS; i++) {
+        App &a = mem->apps[i];
+        if (a.refs == 0) {
+            if (freeSlot < 0) freeSlot = i;
+            continue;
+        }
+        if (a.hash == h && strcmp(a.name, name) == 0) {
+            a.refs++;
+            return i;
+        }
+    }
+    // Every name is still used: age out the oldest entries until one is free,
+    // the same way the slab makes room
+    while (freeSlot < 0) {
+        uint8_t app = mem->entries[oldestSlot()].app;
+        evictOldest();
+        if (mem->apps[app].refs == 0) freeSlot = app;
+    }
+    App &a = mem->apps[freeSlot];
+    a.hash = h;
+    a.refs = 1;
+    gb_copy_utf8(a.name, sizeof(a.name), name);
+    return freeSlot;
+}
+
+// Find room for `len` text bytes, evicting old entries as needed
+static uint32_t allocText(uint32_t len) {
+    for (;;) {
+        if (ringCount < NOTIF_STORE_CAPACITY) {
+            if (ringCount == 0) {
+                slabHead = 0;
+                return 0;
+            }
+            uint32_t tail = mem->entries[oldestSlot()].textOff;
+            if (slabHead > tail) {
+                if (NOTIF_STORE_SLAB_SIZE - slabHead >= len) return slabHead;
+                if (tail >= len) return 0;  // wrap, the end of the slab is wasted
+            } else if (slabHead < tail && tail - slabHead >= len) {
+                return slabHead;
+            }
+        }
+        evictOldest();
+    }
+}
+
+static void fillView(const Entry &e, notif_view_t *out) {
+    const char *text = &mem->slab[e.textOff];
+    out->id = e.id;
+    out->src = mem->apps[e.app].name;
+    out->sender = text;
+    out->title = text + e.titleRel;
+    out->body = text + e.bodyRel;
+}
+
+bool notification_store_init() {
+    mem = (StoreMem *)heap_caps_malloc(sizeof(StoreMem), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    bool psram = mem != nullptr;
+    if (!mem) mem = (StoreMem *)heap_caps_malloc(sizeof(StoreMem), MALLOC_CAP_8BIT);
+    if (!mem) {
+        USBSerial.println("[NOTIF] Store allocation failed!");
+        return false;
+    }
+
+    memset(mem->entries, 0, sizeof(mem->entries));
+    memset(mem->apps, 0, sizeof(mem->apps));
+    memset(mem->index, 0xFF, sizeof(mem->index));
+
+    // Fixed cost per slot, plus the slab share at full capacity
+    size_t perEntry = sizeof(Entry) + sizeof(uint16_t) * INDEX_SLOTS / NOTIF_STORE_CAPACITY;
+    USBSerial.printf("[NOTIF] Store: %d entries in %s, %u KB total, %u B/entry index + %u B/entry text\n",
+        NOTIF_STORE_CAPACITY, psram ? "PSRAM" : "internal RAM",
+        (unsigned)(sizeof(StoreMem) / 1024), (unsigned)perEntry,
+        (unsigned)(NOTIF_STORE_SLAB_SIZE / NOTIF_STORE_CAPACITY));
+    return true;
+}
+
+bool notification_store_add(const bt_notification_t *notif) {
+    if (!mem) return false;
+
+    notification_store_remove(notif->id);
+
+    size_t senderLen = strlen(notif->sender);
+    size_t titleLen = strlen(notif->title);
+    size_t bodyLen = strlen(notif->body);
+    uint32_t len = senderLen + titleLen + bodyLen + 3;
+
+    // Before the text: interning may evict entries, which can reset the slab
+    uint8_t app = internApp(notif->src);
+    uint32_t off = allocText(len);
+    char *text = &mem->slab[off];
+    memcpy(text, notif->sender, senderLen + 1);
+    memcpy(text + senderLen + 1, notif->title, titleLen + 1);
+    memcpy(text + senderLen + titleLen + 2, notif->body, bodyLen + 1);
+    slabHead = off + len;
+
+    uint16_t slot = ringHead;
+    Entry &e = mem->entries[slot];
+    e.id = notif->id;
+    e.textOff = off;
+    e.textLen = len;
+    e.titleRel = senderLen + 1;
+    e.bodyRel = senderLen + titleLen + 2;
+    e.app = app;
+    e.live = 1;
+
+    ringHead = (ringHead + 1) % NOTIF_STORE_CAPACITY;
+    ringCount++;
+    liveCount++;
+    indexInsert(e.id, slot);
+    return true;
+}
+
+bool notification_store_remove(uint32_t id) {
+    if (!mem) return false;
+    int slot = indexFind(id);
+    if (slot < 0) return false;
+
+    mem->entries[mem->index[slot]].live = 0;
+    indexErase(slot);
+    liveCount--;
+    return true;
+}
+
+bool notification_store_find(uint32_t id, notif_view_t *out) {
+    if (!mem) return false;
+    int slot = indexFind(id);
+    if (slot < 0) return false;
+    fillView(mem->entries[mem->index[slot]], out);
+    return true;
+}
+
+bool notification_store_get(int nth, notif_view_t *out) {
+    if (!mem || nth < 0 || nth >= liveCount) return false;
+    for (int i = 1; i <= ringCount; i++) {
+        const Entry &e = mem->entries[(ringHead - i + NOTIF_STORE_CAPACITY) % NOTIF_STORE_CAPACITY];
+        if (!e.live) continue;
+        if (nth-- == 0) {
+            fillView(e, out);
+            return true;
+        }
+    }
+    return false;
+}
+
+int notification_store_count() {
+    return liveCount;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include "gb_protocol.h"
+
+// Notification history kept in PSRAM.
+// Text lives in a circular slab (oldest entries are evicted to make room),
+// app names are interned, and ids are indexed by a small open-addressing hash.
+#define NOTIF_STORE_CAPACITY   128          // entries
+#define NOTIF_STORE_SLAB_SIZE  (48 * 1024)  // bytes of sender/title/body text
+#define NOTIF_STORE_MAX_APPS   48           // distinct interned app names
+
+// Read-only view of a stored notification. Pointers stay valid until the next
+// notification_store_add().
+struct notif_view_t {
+    uint32_t id;
+    const char *src;
+    const char *sender;
+    const char *title;
+    const char *body;
+};
+
+// Allocate the store (PSRAM if available) and log its footprint
+bool notification_store_init();
+
+// Add a notification, replacing any existing one with the same id
+bool notification_store_add(const bt_notification_t *notif);
+
+// Remove by id in O(1); returns false if the id is not stored
+bool notification_store_remove(uint32_t id);
+
+bool notification_store_find(uint32_t id, notif_view_t *out);
+
+// nth most recent live notification (0 = newest)
+bool notification_store_get(int nth, notif_view_t *out);
+
+int notification_store_count();
@@ -0,0 +1,175 @@
+#include "perf.h"
+
+#ifdef WIZWATCH_PERF
+
+#include <lvgl.h>
+#include "display.h"
+#include "ui/WizWatch/src/ui/fonts.h"
+
+// Histogram: 4 sub-buckets per power of two of cycles, so p99 is within ~25%
+#define PERF_SUB_BITS     2
+#define PERF_SUB_BUCKETS  (1 << PERF_SUB_BITS)
+#define PERF_BUCKETS      (32 * PERF_SUB_BUCKETS)
+
+struct PhaseWindow {
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+  uint64_t sumCycles;
+  uint16_t hist[PERF_BUCKETS];
+};
+
+static const char *const phaseNames[PERF_PHASES] = {
+  "loop", "lvgl", "flush", "ui_tick", "rtc", "brightness", "bluetooth"
+};
+
+static PhaseWindow live[PERF_PHASES];
+static perf_phase_stats_t published[PERF_PHASES];
+static portMUX_TYPE perfMux = portMUX_INITIALIZER_UNLOCKED;  // the flush task records too
+
+static uint32_t frames = 0;
+static uint32_t windowStartMs = 0;
+static display_flush_stats_t windowFlush;
+
+// Last full window
+static uint32_t fps = 0;
+static uint32_t loadPct = 0;
+static uint32_t flushKBps = 0;
+
+static lv_obj_t *overlay = nullptr;
+
+static int bucketOf(uint32_t cycles) {
+  if (cycles < 2 * PERF_SUB_BUCKETS) return cycles;
+  int msb = 31 - __builtin_clz(cycles);
+  int sub = (cycles >> (msb - PERF_SUB_BITS)) & (PERF_SUB_BUCKETS - 1);
+  return msb * PERF_SUB_BUCKETS + sub;
+}
+
+// Largest cycle count that lands in bucket b
+static uint32_t bucketCeiling(int b) {
+  if (b < 2 * PERF_SUB_BUCKETS) return b;
+  int msb = b / PERF_SUB_BUCKETS;
+  int sub = b % PERF_SUB_BUCKETS;
+  return (((uint64_t)(PERF_SUB_BUCKETS + sub + 1)) << (msb - PERF_SUB_BITS)) - 1;
+}
+
+void perf_record(perf_phase_t phase, uint32_t cycles) {
+  portENTER_CRITICAL(&perfMux);
+  PhaseWindow *w = &live[phase];
+  if (w->count == 0 || cycles < w->minCycles) w->minCycles = cycles;
+  if (cycles > w->maxCycles) w->maxCycles = cycles;
+  w->sumCycles += cycles;
+  w->count++;
+  uint16_t *slot = &w->hist[bucketOf(cycles)];
+  if (*slot < UINT16_MAX) (*slot)++;
+  portEXIT_CRITICAL(&perfMux);
+}
+
+static void publish(perf_phase_stats_t *out, const PhaseWindow *w, uint32_t mhz) {
+  memset(out, 0, sizeof(*out));
+  if (w->count == 0) return;
+  out->count = w->count;
+  out->minUs = w->minCycles / mhz;
+  out->maxUs = w->maxCycles / mhz;
+  out->avgUs = w->sumCycles / w->count / mhz;
+
+  uint32_t target = w->count - w->count / 100;
+  uint32_t seen = 0;
+  for (int b = 0; b < PERF_BUCKETS; b++) {
+    seen += w->hist[b];
+    if (seen >= target) {
+      out->p99Us = min(bucketCeiling(b), w->maxCycles) / mhz;
+      break;
+    }
+  }
+}
+
+static int worstPhase() {
+  int worst = PERF_LVGL;
+  for (int i = PERF_LVGL; i < PERF_PHASES; i++) {
+    if (published[i].p99Us > published[worst].p99Us) worst = i;
+  }
+  return worst;
+}
+
+static void updateOverlay() {
+  int worst = worstPhase();
+  lv_label_set_text_fmt(overlay, "%lu fps  cpu %lu%%  flush %lu.%lu MB/s\nworst %s p99 %lu.%lu ms",
+                        fps, loadPct, flushKBps / 1000, flushKBps % 1000 / 100,
+                        phaseNames[worst], published[worst].p99Us / 1000,
+                        published[worst].p99Us % 1000 / 100);
+}
+
+static void window_cb(lv_timer_t *timer) {
+  static PhaseWindow snapshot[PERF_PHASES];
+  uint32_t now = millis();
+  uint32_t elapsedMs = now - windowStartMs;
+  if (elapsedMs == 0) return;
+
+  portENTER_CRITICAL(&perfMux);
+  memcpy(snapshot, live, sizeof(live));
+  memset(live, 0, sizeof(live));
+  portEXIT_CRITICAL(&perfMux);
+
+  uint32_t mhz = getCpuFrequencyMhz();
+  for (int i = 0; i < PERF_PHASES; i++) {
+    publish(&published[i], &snapshot[i], mhz);
+  }
+
+  display_flush_stats_t flush;
+  display_get_flush_stats(&flush);
+  fps = frames * 1000 / elapsedMs;
+  loadPct = min<uint64_t>(100, snapshot[PERF_LOOP].sumCycles / mhz / 10 / elapsedMs);
+  flushKBps = (flush.bytes - windowFlush.bytes) / elapsedMs;
+
+  frames = 0;
+  windowStartMs = now;
+  windowFlush = flush;
+
+  if (overlay && !lv_obj_has_flag(overlay, LV_OBJ_FLAG_HIDDEN)) updateOverlay();
+}
+
+static void render_ready_cb(lv_event_t *e) {
+  frames++;
+}
+
+void perf_init() {
+  windowStartMs = millis();
+  display_get_flush_stats(&windowFlush);
+  lv_display_add_event_cb(lv_display_get_default(), render_ready_cb, LV_EVENT_RENDER_READY, nullptr);
+  lv_timer_create(window_cb, PERF_WINDOW_MS, nullptr);
+
+  overlay = lv_label_create(lv_layer_sys());
+  lv_obj_align(overlay, LV_ALIGN_TOP_MID, 0, 4);
+  lv_obj_set_style_text_font(overlay, &ui_font_dot_gothic16_14, LV_PART_MAIN);
+  lv_obj_set_style_text_color(overlay, lv_color_hex(0xb4e898), LV_PART_MAIN);
+  lv_obj_set_style_bg_color(overlay, lv_color_black(), LV_PART_MAIN);
+  lv_obj_set_style_bg_opa(overlay, LV_OPA_70, LV_PART_MAIN);
+  lv_obj_set_style_pad_all(overlay, 4, LV_PART_MAIN);
+  lv_obj_add_flag(overlay, LV_OBJ_FLAG_HIDDEN);
+}
+
+void perf_get_phase(perf_phase_t phase, perf_phase_stats_t *stats) {
+  *stats = published[phase];
+}
+
+void perf_format(char *buf, size_t size) {
+  int n = snprintf(buf, size, "[PERF] %lu fps, cpu %lu%%, flush %lu KB/s\n", fps, loadPct, flushKBps);
+  for (int i = 0; i < PERF_PHASES && n > 0 && (size_t)n < size; i++) {
+    const perf_phase_stats_t *s = &published[i];
+    n += snprintf(buf + n, size - n, "[PERF] %-10s n=%-5lu min %6lu avg %6lu p99 %6lu max %6lu us\n",
+                  phaseNames[i], s->count, s->minUs, s->avgUs, s->p99Us, s->maxUs);
+  }
+}
+
+void perf_overlay_toggle() {
+  if (!overlay) return;
+  if (lv_obj_has_flag(overlay, LV_OBJ_FLAG_HIDDEN)) {
+    updateOverlay();
+    lv_obj_remove_flag(overlay, LV_OBJ_FLAG_HIDDEN);
+  } else {
+    lv_obj_add_flag(overlay, LV_OBJ_FLAG_HIDDEN);
+  }
+}
+
+#endif
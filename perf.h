@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Frame timing instrumentation. Build with -DWIZWATCH_PERF to enable;
+// without it perf_init() is an empty inline and the macros vanish.
+//
+// Each phase is timed with the CPU cycle counter and kept in a one-second
+// window (min/avg/p99/max, p99 from a log-scaled histogram). "perf" on the
+// serial console prints the last window; "perf overlay" toggles a small
+// readout on lv_layer_sys() with FPS, UI-core load, flush MB/s and the
+// phase with the worst p99.
+
+#define PERF_WINDOW_MS 1000
+
+enum perf_phase_t {
+  PERF_LOOP,        // whole awake loop pass, minus the trailing delay
+  PERF_LVGL,        // lv_task_handler(); includes the flush when it is synchronous
+  PERF_FLUSH,       // pixels on the QSPI bus (flush task when asynchronous)
+  PERF_UI_TICK,
+  PERF_RTC,
+  PERF_BRIGHTNESS,
+  PERF_BLUETOOTH,
+  PERF_PHASES
+};
+
+struct perf_phase_stats_t {
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t avgUs;
+  uint32_t p99Us;
+  uint32_t maxUs;
+};
+
+#ifdef WIZWATCH_PERF
+
+void perf_init();  // call after ui_init
+void perf_record(perf_phase_t phase, uint32_t cycles);
+void perf_get_phase(perf_phase_t phase, perf_phase_stats_t *stats);  // last full window
+void perf_format(char *buf, size_t size);
+void perf_overlay_toggle();
+
+inline uint32_t perf_cycles() { return ESP.getCycleCount(); }
+
+#define PERF_BEGIN(phase) uint32_t perfStart_##phase = perf_cycles()
+#define PERF_END(phase)   perf_record(phase, perf_cycles() - perfStart_##phase)
+
+#else
+
+inline void perf_init() {}
+
+#define PERF_BEGIN(phase) ((void)0)
+#define PERF_END(phase)   ((void)0)
+
+#endif
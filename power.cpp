@@ -7,6 +7,8 @@
 #include "brightness.h"
 #include "bluetooth.h"
 #include "notification_ui.h"
+#include "notification_log.h"
+#include <esp_timer.h>
 
 extern HWCDC USBSerial;
 extern Arduino_GFX *gfx;
@@ -15,6 +17,25 @@ XPowersPMU PMU;
 static bool sleeping = false;
 static uint32_t lastActivityTime = 0;
 
+// Wake signalling: sources notify the loop task directly
+static TaskHandle_t loopTask = nullptr;
+static volatile int64_t wakeSignalUs = 0;   // first signal since the loop last woke
+static int64_t sleepStartUs = 0;
+static uint64_t sleepTotalUs = 0;
+static power_wake_stats_t wakeStats;
+
+// Button reads: polled until a press proves the PMU IRQ line works
+static volatile bool pmuIrqSeen = false;   // edge since the last status read
+static bool pmuIrqConfirmed = false;
+static uint32_t lastButtonRead = 0;
+
+#ifdef PMU_IRQ_PIN
+static void IRAM_ATTR pmuIrqHandler() {
+    pmuIrqSeen = true;
+    power_signal_wake_from_isr(POWER_WAKE_BUTTON);
+}
+#endif
+
 void power_init() {
     if (!PMU.begin(Wire, AXP2101_SLAVE_ADDRESS, IIC_SDA, IIC_SCL)) {
         USBSerial.println("PMU init failed!");
@@ -27,12 +48,81 @@ void power_init() {
     PMU.enableIRQ(XPOWERS_AXP2101_PKEY_SHORT_IRQ);
     USBSerial.println("Power button enabled");
     lastActivityTime = millis();
+
+    // setup() and loop() share this task
+    loopTask = xTaskGetCurrentTaskHandle();
+#ifdef PMU_IRQ_PIN
+    pinMode(PMU_IRQ_PIN, INPUT_PULLUP);
+    attachInterrupt(PMU_IRQ_PIN, pmuIrqHandler, FALLING);
+#endif
+}
+
+void power_signal_wake(uint32_t source) {
+    if (!loopTask) return;
+    if (wakeSignalUs == 0) wakeSignalUs = esp_timer_get_time();
+    xTaskNotify(loopTask, source, eSetBits);
+}
+
+void IRAM_ATTR power_signal_wake_from_isr(uint32_t source) {
+    if (!loopTask) return;
+    if (wakeSignalUs == 0) wakeSignalUs = esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(loopTask, source, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+uint32_t power_wait_for_wake() {
+    uint32_t bits = 0;
+    const TickType_t timeout = pdMS_TO_TICKS(pmuIrqConfirmed ? POWER_IRQ_SAFETY_MS : POWER_BUTTON_POLL_MS);
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, timeout) != pdTRUE || bits == 0) {
+        wakeStats.polls++;
+        return 0;
+    }
+
+    wakeStats.wakeups++;
+    if (wakeSignalUs) {
+        uint32_t latency = esp_timer_get_time() - wakeSignalUs;
+        wakeStats.lastLatencyUs = latency;
+        if (latency > wakeStats.maxLatencyUs) wakeStats.maxLatencyUs = latency;
+    }
+    wakeSignalUs = 0;
+    return bits;
+}
+
+void power_get_wake_stats(power_wake_stats_t *stats) {
+    uint64_t asleepUs = sleepTotalUs + (sleeping ? esp_timer_get_time() - sleepStartUs : 0);
+    *stats = wakeStats;
+    stats->sleepSeconds = asleepUs / 1000000;
+    stats->idlePerHour = asleepUs ? (uint64_t)wakeStats.idleWakeups * 3600000000ULL / asleepUs : 0;
+    stats->pollsPerHour = asleepUs ? (uint64_t)wakeStats.polls * 3600000000ULL / asleepUs : 0;
+    stats->buttonIrq = pmuIrqConfirmed;
+}
+
+// Called by the loop when a wakeup turned out to have nothing to do
+void power_note_idle_wakeup() {
+    wakeStats.idleWakeups++;
 }
 
 void power_check_button() {
+    uint32_t now = millis();
+    bool edge = pmuIrqSeen;
+    uint32_t interval = pmuIrqConfirmed ? POWER_IRQ_SAFETY_MS : POWER_BUTTON_POLL_MS;
+    if (!edge && now - lastButtonRead < interval) return;
+    lastButtonRead = now;
+    pmuIrqSeen = false;
+    wakeStats.buttonReads++;
+
     if (PMU.getIrqStatus()) {
         if (PMU.isPekeyShortPressIrq()) {
             USBSerial.println("Power button pressed!");
+#ifdef PMU_IRQ_PIN
+            // A press read without an edge means the line is not wired the way
+            // PMU_IRQ_PIN says; keep (or go back to) polling
+            if (edge != pmuIrqConfirmed) {
+                pmuIrqConfirmed = edge;
+                USBSerial.printf("[PWR] PMU IRQ line %s\n", edge ? "confirmed" : "silent, polling");
+            }
+#endif
             if (sleeping) {
                 notification_ui_set_sleep_bg(false);
                 power_wake();
@@ -47,32 +137,43 @@ void power_check_button() {
 void power_sleep() {
     USBSerial.println("Going to sleep");
     sleeping = true;
+    sleepStartUs = esp_timer_get_time();
+    // Signals from while awake must not wake the first wait
+    if (loopTask) {
+        xTaskNotifyStateClear(loopTask);
+        ulTaskNotifyValueClear(loopTask, UINT32_MAX);
+    }
+    wakeSignalUs = 0;
 
     brightness_set(0);
-    if (gfx) {
-        gfx->displayOff();  // AMOLED panel truly off — saves power
-    }
+    display_set_power(false);  // AMOLED panel truly off — saves power
     bluetooth_sleep();
+    notification_log_flush();  // don't leave history sitting in RAM overnight
     setCpuFrequencyMhz(80);
 
     USBSerial.println("Sleep mode active");
 }
 
 void power_wake() {
+    if (sleeping) sleepTotalUs += esp_timer_get_time() - sleepStartUs;
     sleeping = false;
     lastActivityTime = millis();
 
     setCpuFrequencyMhz(240);
 
-    if (gfx) {
-        gfx->displayOn();
-        delay(50);
-    }
+    display_set_power(true);
+    delay(50);
 
     display_set_brightness(51);
     delay(50);
     brightness_update();
     bluetooth_wake();
+
+    power_wake_stats_t stats;
+    power_get_wake_stats(&stats);
+    USBSerial.printf("[PWR] Wake latency %u us (max %u), %u idle wakeups/h, %u button polls/h (%s) over %u s asleep\n",
+        stats.lastLatencyUs, stats.maxLatencyUs, stats.idlePerHour, stats.pollsPerHour,
+        stats.buttonIrq ? "PMU IRQ" : "no PMU IRQ", stats.sleepSeconds);
 }
 
 bool power_is_sleeping() {
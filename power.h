@@ -1,12 +1,48 @@
 #pragma once
 
+#include <stdint.h>
+
 #define INACTIVITY_TIMEOUT_MS 30000  // 30 seconds
 
+// Wake sources signalled to the sleeping loop
+#define POWER_WAKE_TOUCH   (1 << 0)
+#define POWER_WAKE_BLE     (1 << 1)
+#define POWER_WAKE_BUTTON  (1 << 2)
+
+// Set PMU_IRQ_PIN (e.g. in pin_config.h) if the AXP2101 IRQ line reaches a GPIO.
+// The PMU IRQ status is read over I2C at most every POWER_BUTTON_POLL_MS until a
+// button press has been seen to arrive with an IRQ edge; from then on it is read
+// only when the line fires, plus once every POWER_IRQ_SAFETY_MS.
+#define POWER_BUTTON_POLL_MS 100
+#define POWER_IRQ_SAFETY_MS  60000
+
+struct power_wake_stats_t {
+    uint32_t wakeups;         // signalled loop wakeups while asleep
+    uint32_t idleWakeups;     // of which found nothing to do
+    uint32_t polls;           // button poll timeouts, not counted as wakeups
+    uint32_t pollsPerHour;    // poll timeouts per hour of sleep so far
+    uint32_t buttonReads;     // AXP2101 IRQ status reads over I2C
+    bool buttonIrq;           // PMU IRQ line confirmed; sleep waits no longer poll
+    uint32_t idlePerHour;     // idle wakeups per hour of sleep so far
+    uint32_t lastLatencyUs;   // signal -> loop running
+    uint32_t maxLatencyUs;
+    uint32_t sleepSeconds;
+};
+
 void power_init();
-void power_check_button();
+void power_check_button();  // reads the PMU only when the IRQ line or poll interval calls for it
 void power_sleep();
 void power_wake();
 bool power_is_sleeping();
 void power_optimize_idle();  // Call in loop to reduce power when idle
 void power_reset_inactivity();  // Call on user activity (touch, notification)
 void power_check_inactivity();  // Call in loop to auto-sleep
+
+// Event-driven sleep: the loop blocks in power_wait_for_wake() until an ISR or
+// callback signals a wake source (or the button poll interval passes while the
+// PMU IRQ line is unconfirmed).
+void power_signal_wake(uint32_t source);           // from tasks / callbacks
+void power_signal_wake_from_isr(uint32_t source);  // from interrupt handlers
+uint32_t power_wait_for_wake();                    // returns the POWER_WAKE_* bits, 0 on a poll timeout
+void power_note_idle_wakeup();                     // a signalled wakeup that found nothing to do
+void power_get_wake_stats(power_wake_stats_t *stats);
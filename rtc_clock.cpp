@@ -16,6 +16,11 @@ extern HWCDC USBSerial;
 SensorPCF85063 rtc;
 static uint32_t lastMillis = 0;
 
+// Last minute of day read from the RTC and when; advanced with millis() so
+// other tasks (and the sleeping loop) never need the I2C bus
+static volatile int cachedMinute = -1;
+static volatile uint32_t cachedMinuteAt = 0;
+
 void rtc_init() {
   if (!rtc.begin(Wire, IIC_SDA, IIC_SCL)) {
     USBSerial.println("Failed to find PCF8563 - check your wiring!");
@@ -32,6 +37,8 @@ void rtc_update_display() {
   static char last_buf[6] = {0};
 
   RTC_DateTime datetime = rtc.getDateTime();
+  cachedMinuteAt = millis() - datetime.getSecond() * 1000;
+  cachedMinute = datetime.getHour() * 60 + datetime.getMinute();
 
   char buf[6];  // Reduced buffer size - only need "HH:MM\0"
   snprintf(buf, sizeof(buf), "%02d:%02d",
@@ -65,6 +72,20 @@ void rtc_set_from_epoch(long epoch) {
   rtc_update_display();
 }
 
+uint32_t rtc_get_epoch() {
+  RTC_DateTime dt = rtc.getDateTime();
+
+  // Days since 1970-01-01 (civil calendar, valid for 1970..2099)
+  static const uint16_t daysBeforeMonth[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+  int year = dt.getYear();
+  int month = dt.getMonth();
+  if (month < 1 || month > 12 || year < 1970) return 0;
+  uint32_t days = (year - 1970) * 365 + (year - 1969) / 4 + daysBeforeMonth[month - 1] + dt.getDay() - 1;
+  if (month > 2 && year % 4 == 0) days++;
+
+  return days * 86400 + dt.getHour() * 3600 + dt.getMinute() * 60 + dt.getSecond();
+}
+
 void rtc_tick() {
   uint32_t now = millis();
 
@@ -74,3 +95,9 @@ void rtc_tick() {
     rtc_update_display();
   }
 }
+
+int rtc_minute_of_day() {
+  int minute = cachedMinute;
+  if (minute < 0) return -1;
+  return (minute + (millis() - cachedMinuteAt) / 60000) % 1440;
+}
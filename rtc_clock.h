@@ -9,3 +9,5 @@ void rtc_init();
 void rtc_tick();
 void rtc_update_display();  // Force immediate display update
 void rtc_set_from_epoch(long epoch);  // Set RTC from unix timestamp
+uint32_t rtc_get_epoch();  // Current RTC time as seconds since 1970 (local time)
+int rtc_minute_of_day();  // Cached local minute of day (0..1439) without touching I2C, -1 before the first read
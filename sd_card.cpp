@@ -58,6 +58,7 @@ static lv_fs_res_t sd_tell_cb(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p) {
 }
 
 static lv_fs_drv_t sd_drv;
+static bool mounted = false;
 
 bool sd_card_init() {
   SD_MMC.setPins(SDMMC_CLK, SDMMC_CMD, SDMMC_DATA);
@@ -86,5 +87,10 @@ bool sd_card_init() {
   lv_fs_drv_register(&sd_drv);
 
   USBSerial.println("SD card + LVGL FS driver initialized");
+  mounted = true;
   return true;
 }
+
+bool sd_card_is_mounted() {
+  return mounted;
+}
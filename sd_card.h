@@ -3,3 +3,4 @@
 #include <lvgl.h>
 
 bool sd_card_init();
+bool sd_card_is_mounted();
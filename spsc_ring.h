@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// Lock-free single-producer / single-consumer byte ring.
+// The producer only ever writes `head`, the consumer only ever writes `tail`,
+// so no lock is needed as long as each side stays on its own task.
+// Indices run freely and wrap via the power-of-two mask.
+template <size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    // Producer side: store all of `data` or nothing (a write is never torn).
+    // Returns false and bumps the overflow counter when it does not fit.
+    bool push(const uint8_t *data, size_t len) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (len > N - (head - tail)) {
+            _overflows.fetch_add(1, std::memory_order_relaxed);
+            _droppedBytes.fetch_add(len, std::memory_order_relaxed);
+            return false;
+        }
+
+        size_t idx = head & (N - 1);
+        size_t first = N - idx;
+        if (first > len) first = len;
+        memcpy(&_buf[idx], data, first);
+        memcpy(&_buf[0], data + first, len - first);
+
+        _head.store(head + len, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: copy up to `maxLen` bytes out, returns the count.
+    size_t pop(uint8_t *out, size_t maxLen) {
+        size_t len = peek(out, maxLen);
+        if (len) _tail.store(_tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+        return len;
+    }
+
+    // Consumer side: like pop() but leaves the bytes in the ring.
+    size_t peek(uint8_t *out, size_t maxLen) const {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        size_t len = head - tail;
+        if (len > maxLen) len = maxLen;
+        if (len == 0) return 0;
+
+        size_t idx = tail & (N - 1);
+        size_t first = N - idx;
+        if (first > len) first = len;
+        memcpy(out, &_buf[idx], first);
+        memcpy(out + first, &_buf[0], len - first);
+        return len;
+    }
+
+    // Consumer side: drop everything currently buffered.
+    void clear() {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t used() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    size_t space() const { return N - used(); }
+    // Free-running stream positions (bytes ever pushed / consumed, mod 2^32)
+    uint32_t writePos() const { return _head.load(std::memory_order_acquire); }
+    uint32_t readPos() const { return _tail.load(std::memory_order_acquire); }
+    bool empty() const { return used() == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    uint32_t overflows() const { return _overflows.load(std::memory_order_relaxed); }
+    uint32_t droppedBytes() const { return _droppedBytes.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t _buf[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _overflows{0};
+    std::atomic<uint32_t> _droppedBytes{0};
+};
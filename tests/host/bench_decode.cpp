@@ -0,0 +1,222 @@
+// gb_decode_json() against the old substring-based sanitizer from
+// handleGBMessage() on escape-heavy payloads: accented text as \xNN,
+// atob() titles and bodies, and quoted/backslashed text.
+//
+//   bench_decode [--repeat N] [FILE...]
+//
+// Without files, built-in payloads are used; each FILE holds one GB()
+// payload per line (the text between the parentheses, or whole GB() lines).
+// Reports MB/s, ns/byte and heap allocations per message for both. Exits
+// non-zero if gb_decode_json() fails on a payload or allocates.
+
+#include "gb_protocol.h"
+#include "host_bench.h"
+#include "legacy_string.h"
+
+// ---- Before: handleGBMessage() up to deserializeJson() ----
+
+static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Strict decoder with mbedtls_base64_decode()'s contract: any invalid
+// character or an output larger than `size` is an error
+static bool base64Decode(const char *in, size_t len, uint8_t *out, size_t size, size_t *olen) {
+    uint32_t acc = 0;
+    int bits = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == '=') break;
+        const char *p = strchr(B64, in[i]);
+        if (!p || !in[i]) return false;
+        acc = (acc << 6) | (uint32_t)(p - B64);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (n >= size) return false;
+            out[n++] = (uint8_t)(acc >> bits);
+        }
+    }
+    *olen = n;
+    return true;
+}
+
+static LegacyString decodeAtob(const LegacyString &b64) {
+    size_t olen;
+    unsigned char decoded[256];
+    if (!base64Decode(b64.c_str(), b64.length(), decoded, sizeof(decoded), &olen)) return "?";
+
+    LegacyString result;
+    for (size_t i = 0; i < olen; i++) {
+        uint8_t c = decoded[i];
+        if (c < 0x20) continue;
+        if (c == '"') { result += "\\\""; continue; }
+        if (c == '\\') { result += "\\\\"; continue; }
+        if (c < 0x80) {
+            result += (char)c;
+        } else {
+            result += (char)(0xC0 | (c >> 6));
+            result += (char)(0x80 | (c & 0x3F));
+        }
+    }
+    return result;
+}
+
+static size_t legacySanitize(const LegacyString &json) {
+    LegacyString sanitized = json;
+    int atobPos = 0;
+    while ((atobPos = sanitized.indexOf("atob(\"", atobPos)) >= 0) {
+        int endPos = sanitized.indexOf("\")", atobPos + 6);
+        if (endPos < 0) break;
+        LegacyString b64 = sanitized.substring(atobPos + 6, endPos);
+        LegacyString decoded = decodeAtob(b64);
+        sanitized = sanitized.substring(0, atobPos) + "\"" + decoded + "\"" + sanitized.substring(endPos + 2);
+        atobPos += decoded.length() + 2;
+    }
+
+    int pos = 0;
+    while ((pos = sanitized.indexOf("\\x", pos)) >= 0) {
+        if (pos + 3 < (int)sanitized.length()) {
+            char c = (char)strtol(sanitized.substring(pos + 2, pos + 4).c_str(), nullptr, 16);
+            sanitized = sanitized.substring(0, pos) + LegacyString(c) + sanitized.substring(pos + 4);
+            pos++;
+        } else {
+            pos += 2;
+        }
+    }
+    return sanitized.length();
+}
+
+// ---- Payloads ----
+
+static std::string base64(const std::string &in) {
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < in.size(); i += 3) {
+        uint32_t v = (uint8_t)in[i] << 16 | (uint8_t)in[i + 1] << 8 | (uint8_t)in[i + 2];
+        for (int s = 18; s >= 0; s -= 6) out += B64[(v >> s) & 63];
+    }
+    if (i < in.size()) {
+        uint32_t v = (uint8_t)in[i] << 16 | (i + 1 < in.size() ? (uint8_t)in[i + 1] << 8 : 0);
+        out += B64[(v >> 18) & 63];
+        out += B64[(v >> 12) & 63];
+        out += i + 1 < in.size() ? B64[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+// Latin-1 text with \xNN for every non-ASCII byte, as Gadgetbridge sends it
+static std::string hexEscaped(const std::string &latin1) {
+    std::string out;
+    char esc[5];
+    for (char c : latin1) {
+        if ((uint8_t)c < 0x80) {
+            out += c;
+        } else {
+            snprintf(esc, sizeof(esc), "\\x%02x", (uint8_t)c);
+            out += esc;
+        }
+    }
+    return out;
+}
+
+static std::vector<std::string> builtinPayloads() {
+    // "Réunion déplacée à 14h, préparez le café élémentaire" in Latin-1
+    const std::string french =
+        "R\xe9union d\xe9plac\xe9" "e \xe0 14h, pr\xe9parez le caf\xe9 \xe9l\xe9mentaire. ";
+    std::string longFrench;
+    for (int i = 0; i < 6; i++) longFrench += french;
+
+    std::vector<std::string> p;
+    p.push_back("{\"t\":\"notify\",\"id\":1,\"src\":\"Messages\",\"title\":\"" + hexEscaped(french) +
+                "\",\"body\":\"" + hexEscaped(longFrench) + "\"}");
+    p.push_back("{\"t\":\"notify\",\"id\":2,\"src\":\"Gmail\",\"title\":atob(\"" + base64(french) +
+                "\"),\"body\":atob(\"" + base64(longFrench.substr(0, 250)) + "\")}");
+    p.push_back("{\"t\":\"notify\",\"id\":3,\"src\":\"Signal\",\"title\":\"Bob\",\"body\":"
+                "\"He said \\\"ok\\\"\\nC:\\\\path\\\\to\\\\file \\\"quoted\\\" \\\\ again\"}");
+    p.push_back("{\"t\":\"musicinfo\",\"artist\":\"" + hexEscaped("Ang\xe8le & St\xe9phane") +
+                "\",\"track\":atob(\"" + base64("Balance ton quoi \"live\" \xe0 l'Olympia") +
+                "\"),\"dur\":191}");
+    p.push_back("{\"t\":\"weather\",\"temp\":289,\"txt\":\"" + hexEscaped("tr\xe8s nuageux, l\xe9g\xe8re pluie") +
+                "\",\"loc\":\"" + hexEscaped("Saint-\xc9tienne") + "\"}");
+    return p;
+}
+
+// One payload per line: the text between GB( and ), or whole GB() lines
+static bool readPayloads(const char *path, std::vector<std::string> *out) {
+    std::string data;
+    if (!benchReadFile(path, &data)) return false;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t nl = data.find('\n', pos);
+        if (nl == std::string::npos) nl = data.size();
+        std::string line = data.substr(pos, nl - pos);
+        pos = nl + 1;
+        while (!line.empty() && (uint8_t)line.back() <= 0x20) line.pop_back();
+        size_t start = 0;
+        while (start < line.size() && (uint8_t)line[start] <= 0x20) start++;
+        line.erase(0, start);
+        if (line.compare(0, 3, "GB(") == 0 && line.back() == ')') line = line.substr(3, line.size() - 4);
+        if (!line.empty() && line[0] == '{') out->push_back(line);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    BenchArgs args = {10000, BENCH_WRITE_SIZE, {}};
+    if (!benchParseArgs(argc, argv, "[--repeat N] [FILE...]", &args)) return 2;
+    std::vector<std::string> payloads;
+    for (const char *path : args.paths) {
+        if (!readPayloads(path, &payloads)) return 2;
+    }
+    if (payloads.empty()) payloads = builtinPayloads();
+
+    size_t bytes = 0, escapes = 0;
+    for (const std::string &p : payloads) {
+        bytes += p.size();
+        for (size_t i = 0; i + 1 < p.size(); i++) {
+            if (p[i] == '\\' || p.compare(i, 5, "atob(") == 0) escapes++;
+            if (p[i] == '\\') i++;
+        }
+    }
+    double total = (double)bytes * args.repeat;
+    double messages = (double)payloads.size() * args.repeat;
+
+    std::vector<LegacyString> legacyInputs;
+    for (const std::string &p : payloads) legacyInputs.emplace_back(p.data(), p.size());
+
+    static volatile size_t sink = 0;
+    BenchRun before = benchMeasure([&] {
+        for (int r = 0; r < args.repeat; r++)
+            for (const LegacyString &p : legacyInputs) sink += legacySanitize(p);
+    });
+
+    static char out[GB_JSON_MAX];
+    int failures = 0;
+    BenchRun after = benchMeasure([&] {
+        for (int r = 0; r < args.repeat; r++) {
+            for (const std::string &p : payloads) {
+                int n = gb_decode_json(p.data(), p.size(), out, sizeof(out), GB_TEXT_LIMIT);
+                if (n < 0) failures++;
+                else sink += (size_t)n;
+            }
+        }
+    });
+
+    printf("inputs   %zu payloads, %zu bytes, %zu escapes/atob(), %d passes\n",
+           payloads.size(), bytes, escapes, args.repeat);
+    printf("before   %8.2f MB/s  %6.2f ns/byte  %6.1f allocs/msg\n",
+           total / before.secs / 1e6, before.secs * 1e9 / total, before.allocs / messages);
+    printf("after    %8.2f MB/s  %6.2f ns/byte  %6.1f allocs/msg\n",
+           total / after.secs / 1e6, after.secs * 1e9 / total, after.allocs / messages);
+    printf("speedup  %.1fx\n", before.secs / after.secs);
+
+    if (failures) {
+        printf("FAIL: gb_decode_json() rejected %d payloads\n", failures / args.repeat);
+        return 1;
+    }
+    if (after.allocs) {
+        printf("FAIL: gb_decode_json() allocated %llu times\n", (unsigned long long)after.allocs);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Line framing cost before and after the fixed-buffer framer, on a recorded
+// Gadgetbridge stream fed in BLE-sized writes.
+//
+//   bench_framer [--repeat N] [--write BYTES] FILE...
+//
+// "before" is the old processRxBuffer() loop on LegacyString (String += c,
+// trim, substring(1) per control character, substring for GB() and
+// setTime()); "after" is gb_framer_feed() plus gb_parse_settime(). Reports
+// bytes/sec and heap allocations per line for each. Exits non-zero if the
+// two disagree on the lines they find, or if the new framer allocates.
+
+#include "gb_protocol.h"
+#include "host_bench.h"
+#include "legacy_string.h"
+
+struct Counts {
+    uint32_t lines;
+    uint32_t gb;
+    uint32_t gbBytes;
+    uint32_t setTime;
+    long tsSum;
+
+    bool operator==(const Counts &o) const {
+        return lines == o.lines && gb == o.gb && gbBytes == o.gbBytes &&
+               setTime == o.setTime && tsSum == o.tsSum;
+    }
+};
+
+// ---- Before: the String-based loop from processRxBuffer() ----
+
+static LegacyString rxLine = "";
+
+static void legacyFeed(const char *data, size_t len, Counts *c) {
+    for (size_t i = 0; i < len; i++) {
+        char ch = data[i];
+        if (ch == '\n') {
+            rxLine.trim();
+            // Strip leading control characters (Espruino sends \x10 prefix)
+            while (rxLine.length() > 0 && rxLine[0] < 0x20) {
+                rxLine = rxLine.substring(1);
+            }
+            if (rxLine.length() > 0) {
+                c->lines++;
+                if (rxLine.startsWith("GB(") && rxLine.endsWith(")")) {
+                    LegacyString json = rxLine.substring(3, rxLine.length() - 1);
+                    c->gb++;
+                    c->gbBytes += json.length();
+                } else if (rxLine.startsWith("setTime(")) {
+                    int end = rxLine.indexOf(')');
+                    if (end > 8) {
+                        long ts = rxLine.substring(8, end).toInt();
+                        float tz = 0;
+                        int tzStart = rxLine.indexOf("setTimeZone(");
+                        if (tzStart >= 0) {
+                            int tzEnd = rxLine.indexOf(')', tzStart + 12);
+                            if (tzEnd > tzStart + 12) {
+                                tz = rxLine.substring(tzStart + 12, tzEnd).toFloat();
+                            }
+                        }
+                        c->setTime++;
+                        c->tsSum += ts + (long)(tz * 3600);
+                    }
+                }
+            }
+            rxLine = "";
+        } else {
+            rxLine += ch;
+        }
+    }
+}
+
+// ---- After: gb_framer_feed() ----
+
+static gb_framer_t framer;
+
+static void framerFeed(const char *data, size_t len, Counts *c) {
+    size_t off = 0;
+    while (off < len) {
+        gb_line_t line;
+        off += gb_framer_feed(&framer, &data[off], len - off, &line);
+        if (!line.data) continue;
+        c->lines++;
+        if (line.kind == GB_LINE_GB) {
+            c->gb++;
+            c->gbBytes += line.len;
+        } else if (line.kind == GB_LINE_SETTIME) {
+            long ts;
+            float tz;
+            if (gb_parse_settime(&line, &ts, &tz)) {
+                c->setTime++;
+                c->tsSum += ts + (long)(tz * 3600);
+            }
+        }
+    }
+}
+
+struct Result {
+    Counts counts;      // one pass
+    BenchRun run;
+};
+
+template <typename Feed>
+static Result run(const std::vector<std::string> &inputs, const BenchArgs &args, Feed feed) {
+    Result res = {};
+    res.run = benchMeasure([&] {
+        for (int r = 0; r < args.repeat; r++) {
+            Counts c = {};
+            for (const std::string &data : inputs) {
+                benchWrites(data, args.writeSize, [&](const char *p, size_t len) { feed(p, len, &c); });
+            }
+            res.counts = c;
+        }
+    });
+    return res;
+}
+
+static void report(const char *name, const Result &res, size_t bytes, int repeat) {
+    double lines = (double)res.counts.lines * repeat;
+    printf("%-8s %8.2f MB/s  %7.0f ns/line  %6.2f allocs/line\n", name,
+           bytes * (double)repeat / res.run.secs / 1e6, res.run.secs * 1e9 / lines,
+           res.run.allocs / lines);
+}
+
+int main(int argc, char **argv) {
+    BenchArgs args = {1000, BENCH_WRITE_SIZE, {}};
+    if (!benchParseArgs(argc, argv, "[--repeat N] [--write BYTES] FILE...", &args)) return 2;
+    if (args.paths.empty()) {
+        fprintf(stderr, "no input files\n");
+        return 2;
+    }
+
+    std::vector<std::string> inputs;
+    size_t bytes = 0;
+    for (const char *path : args.paths) {
+        std::string data;
+        if (!benchReadFile(path, &data)) return 2;
+        bytes += data.size();
+        inputs.push_back(std::move(data));
+    }
+
+    gb_framer_reset(&framer);
+    Result before = run(inputs, args, legacyFeed);
+    Result after = run(inputs, args, framerFeed);
+
+    printf("inputs   %zu files, %zu bytes, %u lines, %d passes of %zu-byte writes\n",
+           args.paths.size(), bytes, after.counts.lines, args.repeat, args.writeSize);
+    report("before", before, bytes, args.repeat);
+    report("after", after, bytes, args.repeat);
+    printf("speedup  %.1fx\n", before.run.secs / after.run.secs);
+
+    if (!(before.counts == after.counts)) {
+        printf("MISMATCH: before %u lines (%u GB, %u setTime), after %u lines (%u GB, %u setTime)\n",
+               before.counts.lines, before.counts.gb, before.counts.setTime,
+               after.counts.lines, after.counts.gb, after.counts.setTime);
+        return 1;
+    }
+    if (after.run.allocs) {
+        printf("FAIL: gb_framer_feed() allocated %llu times\n", (unsigned long long)after.run.allocs);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Decode cost of the same messages on the text channel (GB() JSON) and the
+// binary channel (MessagePack frames from tools/gb_msgpack.py).
+//
+//   bench_msgpack [--repeat N] [--write BYTES] STREAM.txt FRAMES.msgpack
+//
+// FRAMES is STREAM converted by make_msgpack_corpus.py. Reports ns and wire
+// bytes per message for the decoder alone (gb_protocol_handle_json() vs
+// gb_protocol_handle_msgpack()) and for the full feed path in BLE-sized writes.
+// Exits non-zero if the two channels do not produce the same events.
+
+#include "gb_protocol.h"
+#include "host_bench.h"
+
+static uint32_t events = 0;
+
+static void countEvent(const gb_event_t *evt) {
+    (void)evt;
+    events++;
+}
+
+struct Result {
+    double ns;          // per message
+    uint32_t events;    // per pass
+};
+
+template <typename Fn>
+static Result timePasses(int repeat, size_t messages, Fn pass) {
+    gb_protocol_reset();
+    events = 0;
+    pass();
+    uint32_t perPass = events;
+
+    BenchRun run = benchMeasure([&] {
+        for (int r = 0; r < repeat; r++) pass();
+    });
+    return {run.secs * 1e9 / ((double)repeat * messages), perPass};
+}
+
+static void report(const char *name, const Result &res, size_t bytes, size_t messages) {
+    printf("%-16s %8.0f ns/msg  %6.1f B/msg  %u events\n",
+           name, res.ns, (double)bytes / messages, res.events);
+}
+
+int main(int argc, char **argv) {
+    BenchArgs args = {1000, BENCH_WRITE_SIZE, {}};
+    const char *usage = "[--repeat N] [--write BYTES] STREAM.txt FRAMES.msgpack";
+    if (!benchParseArgs(argc, argv, usage, &args)) return 2;
+    if (args.paths.size() != 2) {
+        fprintf(stderr, "usage: %s %s\n", argv[0], usage);
+        return 2;
+    }
+    int repeat = args.repeat;
+
+    std::string stream, binary;
+    if (!benchReadFile(args.paths[0], &stream) || !benchReadFile(args.paths[1], &binary)) return 2;
+
+    // Split both inputs into messages with the watch's own framers
+    std::vector<std::string> payloads;
+    size_t jsonBytes = 0;
+    static gb_framer_t framer;
+    gb_framer_reset(&framer);
+    for (size_t off = 0; off < stream.size();) {
+        gb_line_t line;
+        off += gb_framer_feed(&framer, &stream[off], stream.size() - off, &line);
+        if (line.data && line.kind == GB_LINE_GB) {
+            payloads.emplace_back(line.data, line.len);
+            jsonBytes += line.len + 5;  // GB(...)\n
+        }
+    }
+    // Only GB() lines have a binary equivalent
+    std::string gbStream;
+    for (const std::string &p : payloads) gbStream += "GB(" + p + ")\n";
+
+    std::vector<std::string> frames;
+    static gb_bin_framer_t binFramer;
+    gb_bin_framer_reset(&binFramer);
+    const uint8_t *bin = (const uint8_t *)binary.data();
+    for (size_t off = 0; off < binary.size();) {
+        const uint8_t *frame;
+        size_t frameLen;
+        off += gb_bin_framer_feed(&binFramer, &bin[off], binary.size() - off, &frame, &frameLen);
+        if (frame) frames.emplace_back((const char *)frame, frameLen);
+    }
+
+    if (payloads.empty() || payloads.size() != frames.size()) {
+        fprintf(stderr, "%zu GB() lines but %zu frames\n", payloads.size(), frames.size());
+        return 1;
+    }
+    size_t messages = payloads.size();
+
+    gb_protocol_init(countEvent, nullptr);
+
+    Result json = timePasses(repeat, messages, [&] {
+        for (const std::string &p : payloads) gb_protocol_handle_json(p.data(), p.size());
+    });
+    Result msgpack = timePasses(repeat, messages, [&] {
+        for (const std::string &f : frames)
+            gb_protocol_handle_msgpack((const uint8_t *)f.data(), f.size());
+    });
+    Result jsonFeed = timePasses(repeat, messages, [&] {
+        benchWrites(gbStream, args.writeSize, gb_protocol_feed);
+    });
+    Result msgpackFeed = timePasses(repeat, messages, [&] {
+        benchWrites(binary, args.writeSize, [](const char *p, size_t len) {
+            gb_protocol_feed_binary((const uint8_t *)p, len);
+        });
+    });
+
+    printf("inputs           %zu messages, %d passes\n", messages, repeat);
+    report("json decode", json, jsonBytes, messages);
+    report("msgpack decode", msgpack, binary.size(), messages);
+    report("json feed", jsonFeed, gbStream.size(), messages);
+    report("msgpack feed", msgpackFeed, binary.size(), messages);
+    printf("msgpack/json     %.2fx decode time, %.2fx wire bytes\n",
+           msgpack.ns / json.ns, (double)binary.size() / gbStream.size());
+
+    if (json.events != msgpack.events || jsonFeed.events != msgpackFeed.events) {
+        printf("MISMATCH: json %u/%u events, msgpack %u/%u\n",
+               json.events, jsonFeed.events, msgpack.events, msgpackFeed.events);
+        return 1;
+    }
+    return 0;
+}
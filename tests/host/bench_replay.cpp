@@ -0,0 +1,92 @@
+// Replays captured Gadgetbridge streams through the protocol layer the way
+// the protocol task sees them (BLE-sized writes) and reports throughput,
+// memory and crashes.
+//
+//   bench_replay [--repeat N] [--write BYTES] FILE...
+//
+// Each file is first run through the fuzz target in a child process, so a
+// crashing input (e.g. a libFuzzer artifact) is counted instead of taking
+// the bench down. Files that survive are then replayed N times in-process.
+// Exits non-zero if any input crashed.
+
+#include "gb_protocol.h"
+#include "host_bench.h"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint32_t events = 0;
+
+static void countEvent(const gb_event_t *evt) {
+    (void)evt;
+    events++;
+}
+
+// Run the fuzz target on one input in a child; true if it exited normally
+static bool survives(const std::string &data) {
+    pid_t pid = fork();
+    if (pid < 0) return true;
+    if (pid == 0) {
+        LLVMFuzzerTestOneInput((const uint8_t *)data.data(), data.size());
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char **argv) {
+    BenchArgs args = {100, BENCH_WRITE_SIZE, {}};
+    if (!benchParseArgs(argc, argv, "[--repeat N] [--write BYTES] FILE...", &args)) return 2;
+    if (args.paths.empty()) {
+        fprintf(stderr, "no input files\n");
+        return 2;
+    }
+    const std::vector<const char *> &paths = args.paths;
+    int repeat = args.repeat;
+    size_t writeSize = args.writeSize;
+
+    std::vector<std::string> inputs;
+    size_t bytes = 0;
+    int crashes = 0;
+    for (const char *path : paths) {
+        std::string data;
+        if (!benchReadFile(path, &data)) return 2;
+        if (!survives(data)) {
+            printf("CRASH   %s\n", path);
+            crashes++;
+            continue;
+        }
+        bytes += data.size();
+        inputs.push_back(std::move(data));
+    }
+
+    gb_protocol_init(countEvent, nullptr);
+    BenchRun run = benchMeasure([&] {
+        for (int r = 0; r < repeat; r++) {
+            for (const std::string &data : inputs) {
+                gb_protocol_reset();
+                benchWrites(data, writeSize, gb_protocol_feed);
+            }
+        }
+    });
+    double secs = run.secs;
+
+    gb_protocol_stats_t stats;
+    gb_protocol_get_stats(&stats);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("inputs    %zu files, %zu bytes, %d passes of %zu-byte writes\n",
+           paths.size(), bytes, repeat, writeSize);
+    printf("messages  %u lines -> %u events in %.1f ms: %.0f msgs/s, %.2f MB/s\n",
+           stats.lines, events, secs * 1e3, stats.lines / secs, bytes * (double)repeat / secs / 1e6);
+    printf("memory    arena peak %u B, heap spills %u, max RSS %ld KB\n",
+           stats.arenaPeak, stats.heapAllocs, usage.ru_maxrss);
+    printf("errors    parse %u, unknown type %u, oversized %u, overlong %u\n",
+           stats.parseErrors, stats.unknownTypes, stats.oversized, stats.overlong);
+    printf("crashes   %d of %zu inputs\n", crashes, paths.size());
+    return crashes ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+// libFuzzer target for the Gadgetbridge protocol layer. Every input goes
+// through the text path (in BLE-sized writes), the binary channel and the
+// escape decoder on its own; events are checked for unterminated fields.
+// Also linked into bench_replay, which runs it over corpus files.
+
+#include "gb_protocol.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_WRITE_SIZE 20   // default ATT MTU minus the header
+
+static void requireTerminated(const char *s, size_t size) {
+    if (strnlen(s, size) >= size) abort();
+}
+
+static void checkEvent(const gb_event_t *evt) {
+    switch (evt->kind) {
+    case GB_EVT_NOTIFY:
+        requireTerminated(evt->notify.src, sizeof(evt->notify.src));
+        requireTerminated(evt->notify.sender, sizeof(evt->notify.sender));
+        requireTerminated(evt->notify.title, sizeof(evt->notify.title));
+        requireTerminated(evt->notify.body, sizeof(evt->notify.body));
+        break;
+    case GB_EVT_MUSIC_INFO:
+        requireTerminated(evt->music.artist, sizeof(evt->music.artist));
+        requireTerminated(evt->music.track, sizeof(evt->music.track));
+        break;
+    case GB_EVT_WEATHER:
+        requireTerminated(evt->weather.txt, sizeof(evt->weather.txt));
+        break;
+    case GB_EVT_CALL:
+        requireTerminated(evt->call.cmd, sizeof(evt->call.cmd));
+        requireTerminated(evt->call.name, sizeof(evt->call.name));
+        break;
+    default:
+        break;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static bool initialized = false;
+    if (!initialized) {
+        gb_protocol_init(checkEvent, nullptr);
+        initialized = true;
+    }
+    gb_protocol_reset();
+
+    for (size_t off = 0; off < size; off += FUZZ_WRITE_SIZE) {
+        size_t len = size - off < FUZZ_WRITE_SIZE ? size - off : FUZZ_WRITE_SIZE;
+        gb_protocol_feed((const char *)data + off, len);
+    }
+    // A line left open at the end still goes through the parser
+    gb_protocol_feed("\n", 1);
+
+    gb_protocol_feed_binary(data, size);
+
+    if (size <= GB_LINE_MAX) {
+        static char out[GB_JSON_MAX];
+        gb_decode_json((const char *)data, size, out, sizeof(out), GB_TEXT_LIMIT);
+    }
+    return 0;
+}
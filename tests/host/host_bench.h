@@ -0,0 +1,89 @@
+#pragma once
+
+// Shared pieces of the host benches: command line, input files, BLE-sized
+// writes, timing and heap allocation counting. Each bench is a single
+// translation unit, so the operator new replacement below is defined once.
+
+#include <chrono>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define BENCH_WRITE_SIZE 20   // default ATT MTU minus the header
+
+// Heap allocations since start-up: operator new plus LegacyString
+inline uint64_t benchAllocs = 0;
+
+void *operator new(size_t size) {
+    benchAllocs++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct BenchArgs {
+    int repeat;
+    size_t writeSize;
+    std::vector<const char *> paths;
+};
+
+// Parse [--repeat N] [--write BYTES] FILE...; false (after printing usage) on bad values
+static inline bool benchParseArgs(int argc, char **argv, const char *usage, BenchArgs *args) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            args->repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            args->writeSize = (size_t)atoi(argv[++i]);
+        } else {
+            args->paths.push_back(argv[i]);
+        }
+    }
+    if (args->repeat <= 0 || args->writeSize == 0) {
+        fprintf(stderr, "usage: %s %s\n", argv[0], usage);
+        return false;
+    }
+    return true;
+}
+
+static inline bool benchReadFile(const char *path, std::string *out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out->append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// Hand `data` to `feed(ptr, len)` in writes of at most `writeSize` bytes
+template <typename Feed>
+static void benchWrites(const std::string &data, size_t writeSize, Feed feed) {
+    for (size_t off = 0; off < data.size(); off += writeSize) {
+        size_t len = data.size() - off < writeSize ? data.size() - off : writeSize;
+        feed(data.data() + off, len);
+    }
+}
+
+// Wall time and heap allocations of one measured run
+struct BenchRun {
+    double secs;
+    uint64_t allocs;
+};
+
+template <typename Fn>
+static BenchRun benchMeasure(Fn fn) {
+    uint64_t allocs = benchAllocs;
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {secs, benchAllocs - allocs};
+}
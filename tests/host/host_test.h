@@ -0,0 +1,27 @@
+#pragma once
+
+// Minimal checks for the host tests: report every failure, exit non-zero at the end
+#include <stdio.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        hostTestFailures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long _a = (long long)(a), _b = (long long)(b); \
+    if (_a != _b) { \
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+        hostTestFailures++; \
+    } \
+} while (0)
+
+static inline int hostTestResult(const char *name) {
+    if (hostTestFailures) fprintf(stderr, "%s: %d check(s) failed\n", name, hostTestFailures);
+    else printf("%s: ok\n", name);
+    return hostTestFailures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+// Host stand-in for the Arduino String the protocol code used before the
+// fixed-buffer framer and decoder. It follows the ESP32 core's WString
+// allocation behaviour closely enough to count allocations: 11-byte inline
+// buffer, reserve() grows to the exact size, assignment reuses the buffer,
+// and `a + b + c` copies `a` once and appends the rest in place.
+// Only what the old processRxBuffer()/handleGBMessage() called is here.
+
+#pragma once
+
+#include "host_bench.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+class LegacyString {
+public:
+    LegacyString() { sso[0] = '\0'; }
+    LegacyString(const char *s) : LegacyString() { assign(s, strlen(s)); }
+    LegacyString(const char *s, size_t n) : LegacyString() { assign(s, n); }
+    explicit LegacyString(char c) : LegacyString() { assign(&c, 1); }
+    LegacyString(const LegacyString &o) : LegacyString() { assign(o.c_str(), o.len); }
+    LegacyString(LegacyString &&o) noexcept : LegacyString() { take(o); }
+    ~LegacyString() { free(heap); }
+
+    LegacyString &operator=(const LegacyString &o) {
+        if (this != &o) assign(o.c_str(), o.len);
+        return *this;
+    }
+    LegacyString &operator=(LegacyString &&o) noexcept {
+        if (this != &o) { free(heap); heap = nullptr; take(o); }
+        return *this;
+    }
+    LegacyString &operator=(const char *s) { assign(s, strlen(s)); return *this; }
+
+    LegacyString &operator+=(char c) { concat(&c, 1); return *this; }
+    LegacyString &operator+=(const char *s) { concat(s, strlen(s)); return *this; }
+    LegacyString &operator+=(const LegacyString &o) { concat(o.c_str(), o.len); return *this; }
+
+    const char *c_str() const { return heap ? heap : sso; }
+    size_t length() const { return len; }
+    char operator[](size_t i) const { return c_str()[i]; }
+
+    bool startsWith(const char *p) const {
+        size_t n = strlen(p);
+        return len >= n && memcmp(c_str(), p, n) == 0;
+    }
+    bool endsWith(const char *p) const {
+        size_t n = strlen(p);
+        return len >= n && memcmp(c_str() + len - n, p, n) == 0;
+    }
+    int indexOf(char c, size_t from = 0) const {
+        if (from >= len) return -1;
+        const char *p = (const char *)memchr(c_str() + from, c, len - from);
+        return p ? (int)(p - c_str()) : -1;
+    }
+    int indexOf(const char *s, size_t from = 0) const {
+        if (from >= len) return -1;
+        const char *p = strstr(c_str() + from, s);
+        return p ? (int)(p - c_str()) : -1;
+    }
+    LegacyString substring(size_t from, size_t to) const {
+        if (to > len) to = len;
+        if (from > to) from = to;
+        return LegacyString(c_str() + from, to - from);
+    }
+    LegacyString substring(size_t from) const { return substring(from, len); }
+
+    void trim() {
+        char *b = buf();
+        size_t start = 0;
+        while (start < len && isspace((unsigned char)b[start])) start++;
+        size_t end = len;
+        while (end > start && isspace((unsigned char)b[end - 1])) end--;
+        len = end - start;
+        memmove(b, b + start, len);
+        b[len] = '\0';
+    }
+
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return (float)atof(c_str()); }
+
+    friend LegacyString operator+(const LegacyString &a, const LegacyString &b) {
+        LegacyString r(a);
+        r += b;
+        return r;
+    }
+    friend LegacyString operator+(const LegacyString &a, const char *b) {
+        LegacyString r(a);
+        r += b;
+        return r;
+    }
+    friend LegacyString operator+(LegacyString &&a, const LegacyString &b) {
+        a += b;
+        return static_cast<LegacyString &&>(a);
+    }
+    friend LegacyString operator+(LegacyString &&a, const char *b) {
+        a += b;
+        return static_cast<LegacyString &&>(a);
+    }
+
+private:
+    static constexpr size_t SSO_CAP = 11;
+
+    char sso[SSO_CAP + 1];
+    char *heap = nullptr;
+    size_t len = 0;
+    size_t cap = SSO_CAP;
+
+    char *buf() { return heap ? heap : sso; }
+
+    static int isspace(int c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    void reserve(size_t n) {
+        if (n <= cap) return;
+        char *p = (char *)realloc(heap, n + 1);
+        if (!p) abort();
+        if (!heap) memcpy(p, sso, len + 1);
+        heap = p;
+        cap = n;
+        benchAllocs++;
+    }
+    void assign(const char *s, size_t n) {
+        reserve(n);
+        memmove(buf(), s, n);
+        len = n;
+        buf()[len] = '\0';
+    }
+    void concat(const char *s, size_t n) {
+        reserve(len + n);
+        memmove(buf() + len, s, n);
+        len += n;
+        buf()[len] = '\0';
+    }
+    void take(LegacyString &o) {
+        if (o.heap) {
+            heap = o.heap;
+            cap = o.cap;
+            o.heap = nullptr;
+            o.cap = SSO_CAP;
+        } else {
+            memcpy(sso, o.sso, o.len + 1);
+            cap = SSO_CAP;
+        }
+        len = o.len;
+        o.len = 0;
+        o.sso[0] = '\0';
+    }
+};
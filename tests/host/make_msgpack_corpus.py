@@ -0,0 +1,42 @@
+"""
+Converts a captured GB() text stream into binary-channel frames with
+tools/gb_msgpack.py, so the same messages can be decoded both ways.
+
+Usage: python make_msgpack_corpus.py <stream.txt> <out.msgpack>
+"""
+
+import base64
+import json
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "..", "tools"))
+from gb_msgpack import encode_frame  # noqa: E402
+
+
+def gb_to_json(payload):
+    """What gb_decode_json() does: atob() and \\xNN are Latin-1 text."""
+    payload = re.sub(r'atob\("([^"]*)"\)',
+                     lambda m: json.dumps(base64.b64decode(m.group(1)).decode("latin-1")), payload)
+    payload = re.sub(r"\\x([0-9A-Fa-f]{2})", r"\\u00\1", payload)
+    return json.loads(payload)
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(2)
+    frames = []
+    with open(sys.argv[1], "rb") as f:
+        for raw in f:
+            line = raw.decode("utf-8").strip().lstrip("\x10")
+            if line.startswith("GB(") and line.endswith(")"):
+                frames.append(encode_frame(gb_to_json(line[3:-1])))
+    with open(sys.argv[2], "wb") as f:
+        f.write(b"".join(frames))
+    print(f"{len(frames)} frames, {sum(len(fr) for fr in frames)} bytes")
+
+
+if __name__ == "__main__":
+    main()
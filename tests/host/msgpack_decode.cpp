@@ -0,0 +1,85 @@
+// Feeds binary-channel frames (hex, one per line on stdin) through
+// gb_protocol_feed_binary() in BLE-sized writes and prints every decoded
+// event as a JSON line. Driven by msgpack_loopback.py.
+//
+//   msgpack_decode [WRITE_BYTES] < frames.hex
+
+#include "gb_protocol.h"
+#include "host_bench.h"
+
+static void putString(const char *key, const char *s) {
+    printf(",\"%s\":\"", key);
+    for (; *s; s++) {
+        uint8_t c = (uint8_t)*s;
+        if (c == '"' || c == '\\') printf("\\%c", c);
+        else if (c < 0x20) printf("\\u%04x", c);
+        else putchar(c);
+    }
+    putchar('"');
+}
+
+static void printEvent(const gb_event_t *evt) {
+    printf("{\"kind\":%d", evt->kind);
+    switch (evt->kind) {
+    case GB_EVT_NOTIFY:
+        printf(",\"id\":%u", evt->notify.id);
+        putString("src", evt->notify.src);
+        putString("sender", evt->notify.sender);
+        putString("title", evt->notify.title);
+        putString("body", evt->notify.body);
+        break;
+    case GB_EVT_NOTIFY_DISMISS:
+        printf(",\"id\":%u", evt->notify.id);
+        break;
+    case GB_EVT_MUSIC_INFO:
+        putString("artist", evt->music.artist);
+        putString("track", evt->music.track);
+        printf(",\"dur\":%d,\"c\":%d", evt->music.duration, evt->music.position);
+        break;
+    case GB_EVT_MUSIC_STATE:
+        printf(",\"playing\":%s", evt->music.playing ? "true" : "false");
+        break;
+    case GB_EVT_WEATHER:
+        printf(",\"temp\":%d,\"hum\":%d,\"code\":%d", evt->weather.temp, evt->weather.humidity, evt->weather.code);
+        putString("txt", evt->weather.txt);
+        break;
+    case GB_EVT_CALL:
+        putString("cmd", evt->call.cmd);
+        putString("name", evt->call.name);
+        break;
+    case GB_EVT_FIND:
+        printf(",\"n\":%s", evt->find ? "true" : "false");
+        break;
+    case GB_EVT_SET_TIME:
+        printf(",\"ts\":%ld", evt->time.ts);
+        break;
+    default:
+        break;
+    }
+    printf("}\n");
+}
+
+int main(int argc, char **argv) {
+    size_t writeSize = argc > 1 ? (size_t)atoi(argv[1]) : BENCH_WRITE_SIZE;
+    if (writeSize == 0) writeSize = BENCH_WRITE_SIZE;
+
+    std::string stream;
+    char line[8192];
+    while (fgets(line, sizeof(line), stdin)) {
+        for (char *p = line; p[0] && p[1] && p[0] != '\n'; p += 2) {
+            char hex[3] = { p[0], p[1], 0 };
+            stream.push_back((char)strtol(hex, nullptr, 16));
+        }
+    }
+
+    gb_protocol_init(printEvent, nullptr);
+    benchWrites(stream, writeSize, [](const char *p, size_t len) {
+        gb_protocol_feed_binary((const uint8_t *)p, len);
+    });
+
+    gb_protocol_stats_t stats;
+    gb_protocol_get_stats(&stats);
+    fprintf(stderr, "frames %u, overlong %u, parse errors %u, unknown %u\n",
+            stats.binFrames, stats.binOverlong, stats.parseErrors, stats.unknownTypes);
+    return 0;
+}
@@ -0,0 +1,120 @@
+"""
+Loopback test for the binary channel: encodes messages with
+tools/gb_msgpack.py, decodes them with the watch's parser (msgpack_decode)
+and checks every field that reaches the UI.
+
+Usage: python msgpack_loopback.py <msgpack_decode binary>
+"""
+
+import json
+import os
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "..", "tools"))
+from gb_msgpack import encode_frame  # noqa: E402
+
+# gb_event_kind_t
+NOTIFY, NOTIFY_DISMISS, MUSIC_INFO, MUSIC_STATE, WEATHER, CALL, FIND, GPS_QUERY, SET_TIME = range(1, 10)
+
+# Field sizes from gb_protocol.h, including the terminator
+SIZES = {"src": 32, "sender": 64, "title": 96, "body": 256, "artist": 64, "track": 96,
+         "txt": 48, "cmd": 16, "name": 64}
+
+
+def cut(text, size):
+    """gb_copy_utf8(): at most size - 1 bytes, never half a character."""
+    data = text.encode("utf-8")
+    if len(data) < size:
+        return text
+    end = size - 1
+    while end > 0 and (data[end] & 0xC0) == 0x80:
+        end -= 1
+    return data[:end].decode("utf-8")
+
+
+def strings(msg, *keys, defaults=None):
+    defaults = defaults or {}
+    return {k: cut(msg.get(k, defaults.get(k, "")), SIZES[k]) for k in keys}
+
+
+def expected(msg):
+    t = msg["t"]
+    if t == "notify":
+        return {"kind": NOTIFY, "id": msg.get("id", 0),
+                **strings(msg, "src", "sender", "title", "body", defaults={"src": "Unknown"})}
+    if t == "notify-":
+        return {"kind": NOTIFY_DISMISS, "id": msg["id"]}
+    if t == "musicinfo":
+        return {"kind": MUSIC_INFO, "dur": msg.get("dur", 0), "c": msg.get("c", 0),
+                **strings(msg, "artist", "track")}
+    if t == "musicstate":
+        return {"kind": MUSIC_STATE, "playing": msg.get("state") == "play"}
+    if t == "weather":
+        return {"kind": WEATHER, "temp": msg.get("temp", 0), "hum": msg.get("hum", 0),
+                "code": msg.get("code", 0), **strings(msg, "txt")}
+    if t == "call":
+        return {"kind": CALL, **strings(msg, "cmd", "name")}
+    if t == "find":
+        return {"kind": FIND, "n": msg.get("n", False)}
+    if t == "setTime":
+        return {"kind": SET_TIME, "ts": msg["ts"]}
+    if t == "is_gps_active":
+        return {"kind": GPS_QUERY}
+    return None
+
+
+MESSAGES = [
+    {"t": "notify", "id": 1760695201, "src": "Messages", "title": "Alice", "body": "On my way"},
+    {"t": "notify", "id": 2, "src": "WhatsApp", "sender": "Maman", "title": "Famille",
+     "body": "Tu viens dîner ce soir ? 🍲"},
+    # str8 and str16 bodies, cut at a character boundary
+    {"t": "notify", "id": 3, "src": "Mail", "title": "Long", "body": "é" * 100},
+    {"t": "notify", "id": 4, "src": "Mail", "title": "Longer", "body": "Réunion déplacée. " * 40},
+    # Keys the filter must skip: nested arrays and maps, floats, null
+    {"t": "notify", "id": 5, "title": "Dentist", "body": "Tomorrow",
+     "actions": [{"t": "reply", "n": "x"}, [1, 2.5, None]], "extra": {"t": "bad"}},
+    {"t": "notify-", "id": 1760695201},
+    {"t": "musicinfo", "artist": "Daft Punk", "album": "Discovery", "track": "One More Time",
+     "dur": 320, "c": -1, "n": -1},
+    {"t": "musicstate", "state": "play", "position": 12, "shuffle": 1, "repeat": 1},
+    {"t": "musicstate", "state": "pause"},
+    {"t": "weather", "temp": -5, "hum": 72, "code": 803, "txt": "broken clouds", "wind": 11.2,
+     "wdir": 240, "loc": "Lyon", "hi": 1, "lo": -8, "rain": 20, "uv": 1, "feels": -9,
+     "dew": -11, "pressure": 1013, "vis": 10000, "sunrise": 1, "sunset": 2},
+    {"t": "call", "cmd": "incoming", "name": "Bob", "number": "+33612345678"},
+    {"t": "find", "n": True},
+    {"t": "find", "n": False},
+    {"t": "setTime", "ts": 1760695200},
+    {"t": "is_gps_active"},
+    {"t": "alarm", "d": [{"on": True, "h": 7, "m": 30}]},  # unknown: no event
+]
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(2)
+
+    frames = "".join(encode_frame(m).hex() + "\n" for m in MESSAGES)
+    want = [e for e in (expected(m) for m in MESSAGES) if e]
+
+    failures = 0
+    for write_size in (1, 20, 244, 4096):
+        out = subprocess.run([sys.argv[1], str(write_size)], input=frames, capture_output=True,
+                             text=True, check=True)
+        got = [json.loads(line) for line in out.stdout.splitlines()]
+        if len(got) != len(want):
+            print(f"{write_size}-byte writes: {len(got)} events, want {len(want)} ({out.stderr.strip()})")
+            failures += 1
+        for g, w in zip(got, want):
+            if g != w:
+                print(f"{write_size}-byte writes:\n  got  {g}\n  want {w}")
+                failures += 1
+
+    print(f"msgpack_loopback: {len(MESSAGES)} messages, {'ok' if not failures else f'{failures} failures'}")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,123 @@
+// gb_peek_type() takes only the top-level "t", allows JSON whitespace, and
+// messages it can't route are counted instead of vanishing. gb_copy_utf8()
+// never cuts a field in the middle of a character, and atob() text is cut to
+// the field its key lands in.
+
+#include "gb_protocol.h"
+#include "host_test.h"
+#include <string.h>
+#include <string>
+
+static int events = 0;
+
+static void sink(const gb_event_t *evt) {
+    (void)evt;
+    events++;
+}
+
+static void expectType(const char *json, const char *type) {
+    char out[GB_TYPE_NAME_MAX];
+    bool ok = gb_peek_type(json, out, sizeof(out));
+    CHECK(ok == (type != nullptr));
+    if (ok && type && strcmp(out, type) != 0) {
+        fprintf(stderr, "peek %s: got %s, want %s\n", json, out, type);
+        hostTestFailures++;
+    }
+}
+
+static void peek() {
+    expectType("{\"t\":\"notify\",\"id\":1}", "notify");
+    expectType(" { \"t\" :\t\"call\" , \"cmd\":\"end\"}", "call");
+    expectType("{\n\"id\":1,\r\n\"t\":\n\"find\"}", "find");
+    expectType("{\"id\":1,\"t\":\"notify\"}", "notify");
+    // Nested or quoted "t" keys come before the real one
+    expectType("{\"a\":{\"t\":\"bad\"},\"t\":\"find\"}", "find");
+    expectType("{\"a\":[1,{\"t\":\"bad\"},\"]\"],\"t\":\"weather\"}", "weather");
+    expectType("{\"b\":\"\\\"t\\\":\\\"bad\",\"t\":\"notify-\"}", "notify-");
+    expectType("{\"tt\":\"bad\",\"t\":\"call\"}", "call");
+
+    expectType("{\"a\":{\"t\":\"bad\"}}", nullptr);
+    expectType("{\"t\":5}", nullptr);
+    expectType("{}", nullptr);
+    expectType("[\"t\",\"notify\"]", nullptr);
+    expectType("{\"t\":\"abcdefghijklmnop\"}", nullptr);   // longer than GB_TYPE_NAME_MAX allows
+    expectType("{\"t\":\"notify", nullptr);
+    expectType("{\"a\":\"unterminated", nullptr);
+}
+
+static void expectCopy(const char *src, size_t size, const char *want) {
+    char out[64];
+    size_t len = gb_copy_utf8(out, size, src);
+    CHECK_EQ(len, strlen(want));
+    if (strcmp(out, want) != 0) {
+        fprintf(stderr, "copy %s into %zu: got %s, want %s\n", src, size, out, want);
+        hostTestFailures++;
+    }
+}
+
+static void copyUtf8() {
+    expectCopy("Alice", 16, "Alice");
+    expectCopy("Alice", 6, "Alice");
+    expectCopy("Alice", 5, "Alic");
+    expectCopy("caf\xc3\xa9", 6, "caf\xc3\xa9");
+    expectCopy("caf\xc3\xa9", 5, "caf");                  // no half of é
+    expectCopy("\xf0\x9f\x8d\xb2 soup", 4, "");           // no part of a 4-byte emoji
+    expectCopy("\xf0\x9f\x8d\xb2 soup", 5, "\xf0\x9f\x8d\xb2");
+
+    char out[4] = "xyz";
+    CHECK_EQ(gb_copy_utf8(out, 0, "abc"), 0);
+    CHECK_EQ(out[0], 'x');
+}
+
+static void atobLimits() {
+    // 40 x "A"; src holds 31 bytes, so 28 + "…"; unknown keys get GB_TEXT_LIMIT
+    const char *in = "{\"t\":\"notify\",\"src\":atob(\"%s\"),\"x\" : atob(\"%s\"),\"title\":atob(\"%s\")}";
+    const char *a40 = "QUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQQ==";
+    char payload[256];
+    snprintf(payload, sizeof(payload), in, a40, a40, a40);
+    char out[256];
+    CHECK(gb_decode_json(payload, strlen(payload), out, sizeof(out), GB_TEXT_LIMIT) > 0);
+    std::string want = "{\"t\":\"notify\",\"src\":\"" + std::string(28, 'A') + "\xE2\x80\xA6\",\"x\" : \"" +
+        std::string(40, 'A') + "\",\"title\":\"" + std::string(40, 'A') + "\"}";
+    if (want != out) {
+        fprintf(stderr, "atob limits: got %s\n", out);
+        hostTestFailures++;
+    }
+
+    // 0 keeps everything
+    CHECK(gb_decode_json(payload, strlen(payload), out, sizeof(out), 0) > 0);
+    CHECK(strstr(out, ("\"src\":\"" + std::string(40, 'A') + "\"").c_str()) != nullptr);
+}
+
+static void counting() {
+    gb_protocol_stats_t before, after;
+    gb_protocol_get_stats(&before);
+
+    const char *noType = "{\"id\":1,\"body\":\"x\"}";
+    gb_protocol_handle_json(noType, strlen(noType));
+    gb_protocol_get_stats(&after);
+    CHECK_EQ(after.parseErrors, before.parseErrors + 1);
+    CHECK_EQ(events, 0);
+
+    // Routed but malformed: a parse error, not a received message
+    const gb_type_t *notify = gb_find_type("notify");
+    const char *broken = "{\"t\":\"notify\",\"id\":}";
+    gb_protocol_handle_json(broken, strlen(broken));
+    gb_protocol_get_stats(&after);
+    CHECK_EQ(after.parseErrors, before.parseErrors + 2);
+    CHECK_EQ(notify->received, 0);
+
+    const char *good = "{ \"t\" : \"notify\", \"id\": 3 }";
+    gb_protocol_handle_json(good, strlen(good));
+    CHECK_EQ(notify->received, 1);
+    CHECK_EQ(events, 1);
+}
+
+int main() {
+    gb_protocol_init(sink, nullptr);
+    peek();
+    copyUtf8();
+    atobLimits();
+    counting();
+    return hostTestResult("test_gb_peek");
+}
@@ -0,0 +1,129 @@
+// Message type table: every built-in type is found and dispatched, unknown
+// types are counted and dropped, and gb_register_type() enforces its limits.
+
+#include "gb_protocol.h"
+#include "host_test.h"
+#include <string.h>
+
+#define BUILTIN_TYPES 9
+
+static gb_event_t lastEvent;
+static int eventCount = 0;
+
+static void sink(const gb_event_t *evt) {
+    lastEvent = *evt;
+    eventCount++;
+}
+
+static void send(const char *json) {
+    gb_protocol_handle_json(json, strlen(json));
+}
+
+static gb_protocol_stats_t stats() {
+    gb_protocol_stats_t s;
+    gb_protocol_get_stats(&s);
+    return s;
+}
+
+static void builtinTypes() {
+    static const struct {
+        const char *json;
+        gb_event_kind_t kind;
+    } cases[] = {
+        { "{\"t\":\"notify\",\"id\":7,\"src\":\"Chat\",\"title\":\"Hi\",\"body\":\"There\"}", GB_EVT_NOTIFY },
+        { "{\"t\":\"notify-\",\"id\":7}",                                       GB_EVT_NOTIFY_DISMISS },
+        { "{\"t\":\"musicinfo\",\"artist\":\"A\",\"track\":\"B\",\"dur\":60}", GB_EVT_MUSIC_INFO },
+        { "{\"t\":\"musicstate\",\"state\":\"play\"}",                          GB_EVT_MUSIC_STATE },
+        { "{\"t\":\"setTime\",\"ts\":1760695200}",                              GB_EVT_SET_TIME },
+        { "{\"t\":\"weather\",\"temp\":289,\"txt\":\"Rain\"}",                  GB_EVT_WEATHER },
+        { "{\"t\":\"call\",\"cmd\":\"incoming\",\"name\":\"Bob\"}",             GB_EVT_CALL },
+        { "{\"t\":\"find\",\"n\":true}",                                        GB_EVT_FIND },
+        { "{\"t\":\"is_gps_active\"}",                                          GB_EVT_GPS_QUERY },
+    };
+
+    size_t registered = 0;
+    for (size_t slot = 0; slot < GB_TYPE_SLOTS; slot++) {
+        if (gb_type_at(slot)) registered++;
+    }
+    CHECK_EQ(registered, BUILTIN_TYPES);
+    CHECK_EQ(sizeof(cases) / sizeof(cases[0]), BUILTIN_TYPES);
+
+    for (const auto &c : cases) {
+        char type[GB_TYPE_NAME_MAX];
+        CHECK(gb_peek_type(c.json, type, sizeof(type)));
+        const gb_type_t *t = gb_find_type(type);
+        CHECK(t != nullptr);
+        if (!t) continue;
+
+        int before = eventCount;
+        send(c.json);
+        CHECK_EQ(eventCount, before + 1);
+        CHECK_EQ(lastEvent.kind, c.kind);
+        CHECK_EQ(t->received, 1);
+    }
+    CHECK_EQ(lastEvent.kind, GB_EVT_GPS_QUERY);
+    CHECK_EQ(stats().unknownTypes, 0);
+    CHECK_EQ(stats().parseErrors, 0);
+}
+
+static void unknownTypes() {
+    static const char *const names[] = { "alarm", "Notify", "notify+", "", "is_gps_activ", "findPhone" };
+    for (const char *name : names) CHECK(gb_find_type(name) == nullptr);
+
+    int before = eventCount;
+    uint32_t unknown = stats().unknownTypes;
+    send("{\"t\":\"alarm\",\"d\":[{\"on\":true,\"h\":7,\"m\":30}]}");
+    send("{\"t\":\"notify+\",\"id\":1}");
+    CHECK_EQ(eventCount, before);
+    CHECK_EQ(stats().unknownTypes, unknown + 2);
+}
+
+static bool decodeAlarm(JsonObjectConst msg, gb_event_t *evt) {
+    (void)msg;
+    evt->kind = GB_EVT_NONE;
+    return true;
+}
+
+static void registration() {
+    static const gb_type_def_t alarm = { "alarm", { "d", nullptr }, decodeAlarm };
+    static const gb_type_def_t longest = { "abcdefghijklmno", { nullptr }, decodeAlarm };   // 15
+    static const gb_type_def_t tooLong = { "abcdefghijklmnop", { nullptr }, decodeAlarm };  // 16
+    static const gb_type_def_t empty = { "", { nullptr }, decodeAlarm };
+    static const gb_type_def_t duplicate = { "notify", { nullptr }, decodeAlarm };
+
+    CHECK(gb_register_type(&alarm));
+    CHECK(!gb_register_type(&alarm));
+    CHECK(!gb_register_type(&duplicate));
+    CHECK(gb_register_type(&longest));
+    CHECK(!gb_register_type(&tooLong));
+    CHECK(!gb_register_type(&empty));
+    CHECK(gb_find_type("abcdefghijklmno") != nullptr);
+    CHECK(gb_find_type("abcdefghijklmnop") == nullptr);
+
+    int before = eventCount;
+    send("{\"t\":\"alarm\",\"d\":[]}");
+    CHECK_EQ(eventCount, before + 1);
+    CHECK_EQ(gb_find_type("alarm")->received, 1);
+
+    // Fill the table up to its 3/4 load factor
+    static char names[GB_TYPE_SLOTS][8];
+    static gb_type_def_t defs[GB_TYPE_SLOTS];
+    size_t added = 0;
+    for (size_t i = 0; i < GB_TYPE_SLOTS; i++) {
+        snprintf(names[i], sizeof(names[i]), "x%zu", i);
+        defs[i] = { names[i], { nullptr }, decodeAlarm };
+        if (gb_register_type(&defs[i])) added++;
+    }
+    CHECK_EQ(BUILTIN_TYPES + 2 + added, GB_TYPE_SLOTS * 3 / 4);   // + alarm, longest
+    for (size_t i = 0; i < added; i++) CHECK(gb_find_type(names[i]) != nullptr);
+    CHECK(gb_find_type("notify") != nullptr);
+    CHECK(gb_find_type("missing") == nullptr);
+}
+
+int main() {
+    gb_protocol_init(sink, nullptr);
+    builtinTypes();
+    unknownTypes();
+    registration();
+    return hostTestResult("test_gb_types");
+}
@@ -0,0 +1,131 @@
+// Two-thread stress test for SpscRing: one producer pushing variable-length
+// writes (all or nothing), one consumer popping in odd-sized chunks. Every
+// write that was accepted must come out whole, in order, and every rejected
+// push must show up in the overflow counters. Most writes are retried until
+// they fit so the ring runs both full and drained.
+
+#include "spsc_ring.h"
+#include "host_test.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define WRITES      100000
+#define RING_SIZE   2048
+#define MAX_WRITE   300
+
+// Record: uint16 length, uint32 sequence, then bytes derived from the sequence
+static size_t makeRecord(uint32_t seq, uint8_t *out) {
+    uint16_t len = 7 + (seq * 2654435761u >> 24) % (MAX_WRITE - 7);
+    memcpy(out, &len, 2);
+    memcpy(out + 2, &seq, 4);
+    for (size_t i = 6; i < len; i++) out[i] = (uint8_t)(seq + i);
+    return len;
+}
+
+static void stress() {
+    static SpscRing<RING_SIZE> ring;
+    std::atomic<bool> done{false};
+    uint32_t accepted = 0;
+    uint32_t rejected = 0;
+    uint64_t acceptedBytes = 0;
+    uint64_t rejectedBytes = 0;
+
+    std::thread producer([&] {
+        uint8_t rec[MAX_WRITE];
+        for (uint32_t seq = 0; seq < WRITES; seq++) {
+            size_t len = makeRecord(seq, rec);
+            bool retry = seq % 4 != 0;
+            for (;;) {
+                if (ring.push(rec, len)) {
+                    accepted++;
+                    acceptedBytes += len;
+                    break;
+                }
+                rejected++;
+                rejectedBytes += len;
+                if (!retry) break;
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    // Consumer: reassemble records from chunks of 1..97 bytes
+    std::vector<uint8_t> stream;
+    uint32_t received = 0;
+    int64_t lastSeq = -1;
+    uint64_t poppedBytes = 0;
+    size_t chunk = 1;
+    uint8_t buf[128];
+    uint8_t expect[MAX_WRITE];
+    for (;;) {
+        bool finished = done.load();
+        size_t n = ring.pop(buf, chunk);
+        chunk = chunk % 97 + 1;
+        poppedBytes += n;
+        stream.insert(stream.end(), buf, buf + n);
+
+        size_t off = 0;
+        while (stream.size() - off >= 6) {
+            uint16_t len;
+            uint32_t seq;
+            memcpy(&len, &stream[off], 2);
+            memcpy(&seq, &stream[off + 2], 4);
+            if (stream.size() - off < len) break;
+            CHECK((int64_t)seq > lastSeq);
+            CHECK_EQ(makeRecord(seq, expect), len);
+            CHECK(memcmp(expect, &stream[off], len) == 0);
+            lastSeq = seq;
+            received++;
+            off += len;
+        }
+        stream.erase(stream.begin(), stream.begin() + off);
+        if (n == 0) {
+            if (finished && ring.empty()) break;
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    CHECK_EQ(received, accepted);
+    CHECK_EQ(poppedBytes, acceptedBytes);
+    CHECK(stream.empty());
+    CHECK_EQ(ring.overflows(), rejected);
+    CHECK_EQ(ring.droppedBytes(), (uint32_t)rejectedBytes);
+    printf("spsc stress: %u of %u writes through, %u pushes rejected\n", accepted, WRITES, rejected);
+}
+
+// Single-threaded edge cases: exact fill, wrap-around, clear
+static void edges() {
+    SpscRing<16> ring;
+    uint8_t data[16];
+    for (int i = 0; i < 16; i++) data[i] = i;
+    CHECK(ring.push(data, 16));
+    CHECK(!ring.push(data, 1));
+    CHECK_EQ(ring.space(), 0);
+
+    uint8_t out[16];
+    CHECK_EQ(ring.pop(out, 10), 10);
+    CHECK(ring.push(data, 10));   // wraps
+    CHECK_EQ(ring.pop(out, 16), 16);
+    CHECK_EQ(out[0], 10);
+    CHECK_EQ(out[6], 0);
+    CHECK_EQ(out[15], 9);
+
+    CHECK(ring.push(data, 5));
+    CHECK_EQ(ring.peek(out, 3), 3);
+    CHECK_EQ(out[2], 2);
+    CHECK_EQ(ring.used(), 5);
+    CHECK_EQ(ring.writePos() - ring.readPos(), 5);
+    ring.clear();
+    CHECK(ring.empty());
+    CHECK_EQ(ring.overflows(), 1);
+    CHECK_EQ(ring.droppedBytes(), 1);
+}
+
+int main() {
+    edges();
+    stress();
+    return hostTestResult("test_spsc_ring");
+}
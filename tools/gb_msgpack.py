@@ -0,0 +1,74 @@
+"""
+Encodes Gadgetbridge messages for WizWatch's binary BLE channel.
+
+Each frame is a little-endian uint16 length followed by a MessagePack map with
+the same keys as the GB() JSON message; "t" must come first. Write the frame
+to characteristic 7A1E0002-5B1F-4C3E-9A56-2D7F0E3B9C10 (e.g. with nRF Connect).
+
+Usage: python gb_msgpack.py '{"t":"notify","id":1,"src":"Chat","title":"Hi","body":"..."}'
+Prints the frame as hex and the size of the equivalent GB() text line.
+"""
+
+import json
+import struct
+import sys
+
+
+def pack(value):
+    """Minimal MessagePack encoder for the types GB messages use."""
+    if value is None:
+        return b"\xc0"
+    if value is True:
+        return b"\xc3"
+    if value is False:
+        return b"\xc2"
+    if isinstance(value, int):
+        if 0 <= value < 0x80:
+            return struct.pack("B", value)
+        if -32 <= value < 0:
+            return struct.pack("b", value)
+        if 0 <= value <= 0xFFFFFFFF:
+            return b"\xce" + struct.pack(">I", value)
+        return b"\xd3" + struct.pack(">q", value)
+    if isinstance(value, float):
+        return b"\xcb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        data = value.encode("utf-8")
+        if len(data) < 32:
+            return struct.pack("B", 0xA0 | len(data)) + data
+        if len(data) < 256:
+            return b"\xd9" + struct.pack("B", len(data)) + data
+        return b"\xda" + struct.pack(">H", len(data)) + data
+    if isinstance(value, list):
+        out = struct.pack("B", 0x90 | len(value)) if len(value) < 16 else b"\xdc" + struct.pack(">H", len(value))
+        return out + b"".join(pack(v) for v in value)
+    if isinstance(value, dict):
+        out = struct.pack("B", 0x80 | len(value)) if len(value) < 16 else b"\xde" + struct.pack(">H", len(value))
+        return out + b"".join(pack(k) + pack(v) for k, v in value.items())
+    raise TypeError(f"cannot encode {type(value).__name__}")
+
+
+def encode_frame(message):
+    if "t" not in message:
+        raise ValueError('message needs a "t" key')
+    # "t" first so the watch can route the message before parsing it
+    ordered = {"t": message["t"], **{k: v for k, v in message.items() if k != "t"}}
+    payload = pack(ordered)
+    if len(payload) > 1024:
+        raise ValueError(f"frame too large ({len(payload)} bytes, max 1024)")
+    return struct.pack("<H", len(payload)) + payload
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    message = json.loads(sys.argv[1])
+    frame = encode_frame(message)
+    text = "GB(" + json.dumps(message, separators=(",", ":")) + ")\n"
+    print(frame.hex())
+    print(f"{len(frame)} bytes binary, {len(text.encode('utf-8'))} bytes as GB() text")
+
+
+if __name__ == "__main__":
+    main()
@@ -2,6 +2,7 @@
 #include <Wire.h>
 #include "HWCDC.h"
 #include "power.h"
+#include "bluetooth.h"
 
 extern HWCDC USBSerial;
 
@@ -15,6 +16,7 @@ std::unique_ptr<Arduino_IIC> FT3168(new Arduino_FT3x68(IIC_Bus, FT3168_DEVICE_AD
 
 void Arduino_IIC_Touch_Interrupt(void) {
   FT3168->IIC_Interrupt_Flag = true;
+  power_signal_wake_from_isr(POWER_WAKE_TOUCH);
 }
 
 void my_touchpad_read(lv_indev_t *indev, lv_indev_data_t *data) {
@@ -25,6 +27,7 @@ void my_touchpad_read(lv_indev_t *indev, lv_indev_data_t *data) {
 
     FT3168->IIC_Interrupt_Flag = false;
     power_reset_inactivity();
+    bluetooth_user_activity();
     data->state = LV_INDEV_STATE_PR;
     data->point.x = touchX;
     data->point.y = touchY;